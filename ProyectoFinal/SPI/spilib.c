@@ -1,5 +1,12 @@
 #include "spilib.h"
+#include <stddef.h>
 
+#ifdef __AVR__
+
+// A byte was written and may still be shifting out
+static bool spi_pending = false;
+
+#ifndef SPI_USART
 
 void spi_init(void) {
     // Configure SCLK, CS_SD, CS_TFT, MOSI, D/C as out, MISO as in (pull up)
@@ -12,9 +19,19 @@ void spi_init(void) {
     SPSR |= (1 << SPI2X);
 }
 
+// Reading SPSR with SPIF set and then SPDR clears SPIF
+void spi_flush(void) {
+    if (spi_pending) {
+        while(!(SPSR & (1 << SPIF)));
+        spi_pending = false;
+    }
+}
+
 // This function transmits a single byte over the SPI bus.
-// It does *not* control the CS line
+// It does *not* control the CS line. It waits for the previous byte
+// instead of its own, so the caller's work overlaps the transfer.
 void spi_tx(uint8_t data, bool commandmode) {
+    spi_flush();
     // CM true -> D/C low
     if (commandmode) {
         TOGGLE_COMMAND();
@@ -22,14 +39,149 @@ void spi_tx(uint8_t data, bool commandmode) {
         TOGGLE_DATA();
     }
     SPDR = data;
+    spi_pending = true;
+}
+
+void spi_tx_repeat(uint16_t data, uint16_t count) {
+    uint8_t hi = data >> 8, lo = data & 0xff;
+    if (!count) return;
+    spi_flush();
+    TOGGLE_DATA();
+    // The SPI module has no buffer, each byte is written as soon as the
+    // previous one is out. Only the poll loop is left between bytes.
+    SPDR = hi;
     while(!(SPSR & (1 << SPIF)));
+    SPDR = lo;
+    while (--count) {
+        while(!(SPSR & (1 << SPIF)));
+        SPDR = hi;
+        while(!(SPSR & (1 << SPIF)));
+        SPDR = lo;
+    }
+    spi_pending = true;
 }
 
 // This function receives a single byte over the SPI bus.
 // This is very easy and short if you understood how SPI works.
 // Hint: It is a *full duplex* bus!
 char spi_rx(void) {
+    spi_flush();
     SPDR = 0xFF;
     while(!(SPSR & (1 << SPIF)));
     return SPDR;
-}
\ No newline at end of file
+}
+
+#else /* SPI_USART */
+
+void spi_init(void) {
+    // D/C as out, the mode switch as in (pull up)
+    DDRB |= PIN_DC;
+    DDRB &= ~STATE_SELECT;
+    PORTB |= STATE_SELECT;
+    // XCK0 as output makes the USART the clock master
+    UBRR0 = 0;
+    DDRD |= PIN_USART_SCLK;
+    // Master SPI mode, SPI mode 0, MSB first. Transmitter only: the TFT has
+    // no MISO, and the receiver would take RXD0 (PD0) from the state LED.
+    UCSR0C = (1 << UMSEL01) | (1 << UMSEL00);
+    UCSR0B = (1 << TXEN0);
+    // Baud rate is set after enabling the transmitter: fosc / 2 = 8MHz
+    UBRR0 = 0;
+}
+
+// TXC0 is set once the shift register and the buffer are both empty
+void spi_flush(void) {
+    if (spi_pending) {
+        while(!(UCSR0A & (1 << TXC0)));
+        spi_pending = false;
+    }
+}
+
+// Writes a byte once the transmit buffer has room. TXC0 is cleared by
+// writing a one to it.
+static inline void spi_usart_put(uint8_t data) {
+    while(!(UCSR0A & (1 << UDRE0)));
+    UCSR0A = (1 << TXC0);
+    UDR0 = data;
+}
+
+// D/C is sampled with the last bit of every byte, it can only change once
+// the previous byte is out. Bytes in the same mode go straight to the
+// buffer.
+void spi_tx(uint8_t data, bool commandmode) {
+    bool command = !(PORTB & PIN_DC);
+    if (commandmode != command) {
+        spi_flush();
+        if (commandmode) {
+            TOGGLE_COMMAND();
+        } else {
+            TOGGLE_DATA();
+        }
+    }
+    spi_usart_put(data);
+    spi_pending = true;
+}
+
+void spi_tx_repeat(uint16_t data, uint16_t count) {
+    uint8_t hi = data >> 8, lo = data & 0xff;
+    if (!count) return;
+    if (!(PORTB & PIN_DC)) {
+        spi_flush();
+        TOGGLE_DATA();
+    }
+    while (count--) {
+        spi_usart_put(hi);
+        spi_usart_put(lo);
+    }
+    spi_pending = true;
+}
+
+// Nothing can be read with the receiver off, the clock still runs a byte
+char spi_rx(void) {
+    spi_usart_put(0xFF);
+    spi_pending = true;
+    spi_flush();
+    return (char) 0xFF;
+}
+
+#endif /* SPI_USART */
+
+#else /* __AVR__ */
+
+static SpiTransport spi_transport;
+
+void spi_set_transport(const SpiTransport *transport) {
+    if (transport) {
+        spi_transport = *transport;
+    } else {
+        spi_transport.tx = NULL;
+        spi_transport.tx_repeat = NULL;
+    }
+}
+
+void spi_init(void) {
+}
+
+void spi_flush(void) {
+}
+
+void spi_tx(uint8_t data, bool commandmode) {
+    if (spi_transport.tx) spi_transport.tx(spi_transport.ctx, data, commandmode);
+}
+
+void spi_tx_repeat(uint16_t data, uint16_t count) {
+    if (spi_transport.tx_repeat) {
+        spi_transport.tx_repeat(spi_transport.ctx, data, count);
+        return;
+    }
+    while (count--) {
+        spi_tx(data >> 8, false);
+        spi_tx(data & 0xff, false);
+    }
+}
+
+char spi_rx(void) {
+    return (char) 0xFF;
+}
+
+#endif /* __AVR__ */
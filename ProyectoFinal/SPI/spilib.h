@@ -3,13 +3,41 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#ifdef __AVR__
 #include "../pindefs.h"
+#endif
+
+// TFT transport. By default the SPI module drives the display. With
+// SPI_USART defined in pindefs.h the USART0 in Master SPI mode does instead:
+// its transmit buffer takes the next byte while the current one shifts out,
+// so pixel streams run at the full 8 MHz without a gap between bytes. It
+// leaves no USART for SERIAL_DEBUG.
 
 #define wc(DATA) spi_tx(DATA, true)
 #define wd(DATA) spi_tx(DATA, false)
+// COUNT times the 16 bit DATA, high byte first, in data mode
+#define wr(DATA, COUNT) spi_tx_repeat(DATA, COUNT)
 
 void spi_init(void);
+// Queues a byte. It returns while the byte is still being sent, the next
+// call or spi_flush waits for it.
 void spi_tx(uint8_t data, bool commandmode);
+void spi_tx_repeat(uint16_t data, uint16_t count);
+// Waits until the last byte is out
+void spi_flush(void);
 char spi_rx(void);
 
-#endif /* SPILIB_H_ */
\ No newline at end of file
+#ifndef __AVR__
+// Host builds hand every byte to a transport, such as a mock recording the
+// stream. Without one the bytes are dropped.
+typedef struct spi_transport {
+    void (*tx)(void *ctx, uint8_t data, bool commandmode);
+    // Optional, spi_tx_repeat falls back to tx per byte
+    void (*tx_repeat)(void *ctx, uint16_t data, uint16_t count);
+    void *ctx;
+} SpiTransport;
+
+void spi_set_transport(const SpiTransport *transport);
+#endif
+
+#endif /* SPILIB_H_ */
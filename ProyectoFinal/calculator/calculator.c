@@ -1,4 +1,8 @@
 #include "calculator.h"
+#include "../pindefs.h"
+#include "../display/text.h"
+#include "../fmt/fmt.h"
+#include <math.h>
 
 void drawMajorAxes(uint16_t color) {
     drawFastVLine(TFT_WIDTH / 2, 0, TFT_HEIGHT, color);
@@ -10,58 +14,452 @@ uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
     return color;
 }
 
-uint8_t calculateFunctionPixels(uint8_t *y_vals, char *expression, double range) {
-    // Variables for expression and evaluation results
-    double real_x, real_y, max_y = 0;
-    te_variable vars[] = {{"x", &real_x}};
-    // Compile expression
-    int err = 0;
-    te_expr *expr = te_compile(expression, vars, 1, &err);
-    if (err) return err;
-    // By double passing over all values, we sacrifice speed for memory efficiency
-    if (expr) {
-        // Iterate once to find maximum value by which to scale
-        for (int x = 0; x < 160; x++) {
-            // Transform pixel x coordinate to real x coordinate
-            real_x = range * ((2.0 * x)/TFT_WIDTH - 1);
-            // Evaluate expression
-            real_y = te_eval(expr);
-            // Take absolute value of computed y value
-            real_y = real_y < 0 ? real_y * -1 : real_y;
-            // Check if abs(real_y) is larger than a previous large y
-            if (real_y > max_y) {
-                // Replace maximum y value if it is larger
-                max_y = real_y;
+const uint16_t plot_colors[PLOT_MAX_FUNCS] = {ST7735_OLDGREEN, ST7735_MAGENTA, ST7735_CYAN};
+
+uint8_t plot_compile(Plot *plot, char *expression) {
+    te_variable vars[] = {{"x", &plot->real_x}};
+    // Drop the previous plot, it was kept alive for panning and zooming
+    plot_free(plot);
+    // Split at top level commas only, commas inside parentheses belong to
+    // multi-argument functions such as atan2
+    char *func = expression;
+    uint8_t depth = 0;
+    for (char *c = expression; ; c++) {
+        if (*c == '(') depth++;
+        if (*c == ')' && depth) depth--;
+        if ((*c == ',' && !depth) || *c == '\0') {
+            bool last = *c == '\0';
+            if (plot->n_funcs == PLOT_MAX_FUNCS) {
+                plot_free(plot);
+                return 1;
+            }
+            *c = '\0';
+            int err = 0;
+            PROF_BEGIN(PROF_TE_COMPILE);
+            te_expr *expr = te_compile(func, vars, 1, &err);
+            PROF_END(PROF_TE_COMPILE);
+            if (!expr) {
+                plot_free(plot);
+                return err ? err : 1;
+            }
+            plot->exprs[plot->n_funcs++] = expr;
+            if (last) break;
+            func = c + 1;
+        }
+    }
+    return 0;
+}
+
+void plot_free(Plot *plot) {
+    plot_untabulate(plot);
+    for (uint8_t f = 0; f < plot->n_funcs; f++) {
+        te_free(plot->exprs[f]);
+    }
+    plot->n_funcs = 0;
+}
+
+uint8_t plot_tabulate(Plot *plot) {
+    double width = plot->xmax - plot->xmin;
+    double center = (plot->xmin + plot->xmax) / 2;
+    double tol = (plot->ymax - plot->ymin) / TFT_HEIGHT / 4;
+    if (!plot->n_funcs) return 0;
+    if (!plot->tab) {
+        te_expr *wrapper = tab_compile(plot->exprs[0], &plot->real_x, center - width, center + width, tol, &plot->tab);
+        // Out of memory, the function keeps its tree
+        if (!wrapper) return 0;
+        plot->exprs[0] = wrapper;
+    }
+    return tab_fitted_segments(plot->tab);
+}
+
+void plot_untabulate(Plot *plot) {
+    if (!plot->tab) return;
+    te_free(plot->exprs[0]);
+    plot->exprs[0] = plot->tab->expr;
+    plot->tab->expr = NULL;
+    tab_free(plot->tab);
+    plot->tab = NULL;
+}
+
+te_expr *plot_source(const Plot *plot, uint8_t f) {
+    return !f && plot->tab ? plot->tab->expr : plot->exprs[f];
+}
+
+double plot_x(const Plot *plot, int16_t i) {
+    return plot->xmin + (plot->xmax - plot->xmin) * i / TFT_WIDTH;
+}
+
+// Pixel row of a real y value, or one of the PLOT_Y_* markers when it does not
+// land inside the window. Comparing before the cast keeps huge values from
+// wrapping around into the visible rows.
+static uint8_t plot_y_pixel(double real_y, double ymin, double scale) {
+    double row = (real_y - ymin) * scale;
+    if (row != row) return PLOT_Y_NAN;
+    if (row < 0) return PLOT_Y_BELOW;
+    if (row >= TFT_HEIGHT) return PLOT_Y_ABOVE;
+    return (uint8_t) row;
+}
+
+uint8_t plot_sample(Plot *plot, uint8_t f, uint8_t i) {
+    if (!f) return plot->y_vals[i];
+    plot->real_x = plot_x(plot, i);
+    PROF_BEGIN(PROF_TE_EVAL);
+    double real_y = te_eval(plot->exprs[f]);
+    PROF_END(PROF_TE_EVAL);
+    return plot_y_pixel(real_y, plot->ymin, TFT_HEIGHT / (plot->ymax - plot->ymin));
+}
+
+// Evaluates samples [from, to) against the current window. The first
+// function is stored in y_vals, functions first_func onwards are exported.
+// Overlays are only evaluated here while the plot is exported.
+static void plot_sample_range(Plot *plot, uint8_t from, uint8_t to, uint8_t first_func) {
+    double scale = TFT_HEIGHT / (plot->ymax - plot->ymin);
+    uint8_t last_func = plot_export_enabled() ? plot->n_funcs : 1;
+    for (uint8_t x = from; x < to; x++) {
+        // Transform pixel x to real x once, shared by every function
+        plot->real_x = plot_x(plot, x);
+        for (uint8_t f = first_func; f < last_func; f++) {
+            PROF_BEGIN(PROF_TE_EVAL);
+            double real_y = te_eval(plot->exprs[f]);
+            PROF_END(PROF_TE_EVAL);
+            // Transform real y value to pixel y, clip and store
+            if (!f) plot->y_vals[x] = plot_y_pixel(real_y, plot->ymin, scale);
+            plot_export_sample(f, x, plot->real_x, real_y);
+        }
+    }
+}
+
+uint8_t calculateFunctionPixels(Plot *plot, double xmin, double xmax, double ymin, double ymax, bool autoscale) {
+    // Variables for evaluation results
+    double real_y, max_y = 0;
+    if (!plot->n_funcs || xmin >= xmax || (!autoscale && ymin >= ymax)) return 1;
+    plot->xmin = xmin;
+    plot->xmax = xmax;
+    if (autoscale) {
+        // By double passing over all values, we sacrifice speed for memory efficiency.
+        // With a fixed y window this pass is skipped entirely.
+        // Iterate once to find the maximum value by which to scale all functions
+        for (int x = 0; x < TFT_WIDTH; x++) {
+            // Transform pixel x coordinate to real x coordinate, shared by every function
+            plot->real_x = plot_x(plot, x);
+            for (uint8_t f = 0; f < plot->n_funcs; f++) {
+                // Evaluate expression
+                PROF_BEGIN(PROF_TE_EVAL);
+                real_y = te_eval(plot->exprs[f]);
+                PROF_END(PROF_TE_EVAL);
+                // Take absolute value of computed y value
+                real_y = real_y < 0 ? real_y * -1 : real_y;
+                // Check if abs(real_y) is larger than a previous large y,
+                // a pole hit exactly would stretch the window to infinity
+                if (real_y > max_y && !isinf(real_y)) {
+                    // Replace maximum y value if it is larger
+                    max_y = real_y;
+                }
             }
         }
         max_y *= 1.2;
-        // Iterate again to save scaled values in memory
-        for (int x = 0; x < 160; x++) {
-            // Transform pixel x to real x and evaluate
-            real_x = range * ((2.0 * x)/TFT_WIDTH - 1);
-            real_y = te_eval(expr);        
-            // Transform real y value to pixel y, cast and store
-            y_vals[x] = (uint8_t) ((TFT_HEIGHT/2.0) * (real_y / max_y + 1));
+        // Flat or undefined functions still get a usable window
+        if (!(max_y > 0)) max_y = 1;
+        ymin = -max_y;
+        ymax = max_y;
+    }
+    plot->ymin = ymin;
+    plot->ymax = ymax;
+    if (plot_export_enabled()) plot_export_begin(plot->xmin, plot->xmax, plot->ymin, plot->ymax);
+    // Save scaled values in memory
+    plot_sample_range(plot, 0, TFT_WIDTH, 0);
+    return 0;
+}
+
+int16_t plot_row(uint8_t y_val) {
+    if (y_val == PLOT_Y_BELOW) return -1;
+    if (y_val == PLOT_Y_ABOVE) return TFT_HEIGHT;
+    return y_val;
+}
+
+bool plot_segment_visible(uint8_t y0, uint8_t y1) {
+    // Undefined samples break the curve, stretches beyond one edge are not drawn
+    if (y0 == PLOT_Y_NAN || y1 == PLOT_Y_NAN) return false;
+    return !(y0 == y1 && y0 >= TFT_HEIGHT);
+}
+
+int16_t plot_axis_col(const Plot *plot) {
+    if (plot->xmin > 0 || plot->xmax < 0) return -1;
+    int16_t i = (int16_t) (-plot->xmin * TFT_WIDTH / (plot->xmax - plot->xmin) + 0.5);
+    return i < TFT_WIDTH ? PLOT_COL(i) : -1;
+}
+
+int16_t plot_axis_row(const Plot *plot) {
+    if (plot->ymin > 0 || plot->ymax < 0) return -1;
+    int16_t row = (int16_t) (-plot->ymin * TFT_HEIGHT / (plot->ymax - plot->ymin));
+    return row < TFT_HEIGHT ? row : -1;
+}
+
+// Distance between ticks for span over the given pixels: 1, 2 or 5 times a
+// power of ten, at least spacing pixels apart
+static double plot_tick_step(double span, uint8_t pixels, uint8_t spacing) {
+    double raw = span * spacing / pixels;
+    double magnitude = pow(10, floor(log10(raw)));
+    double mantissa = raw / magnitude;
+    if (mantissa <= 1) return magnitude;
+    if (mantissa <= 2) return 2 * magnitude;
+    if (mantissa <= 5) return 5 * magnitude;
+    return 10 * magnitude;
+}
+
+// Step of the x ticks, PLOT_TICK_SPACING_X pixels apart at least and wider
+// while the longest label would not leave PLOT_LABEL_GAP to its neighbours
+static double plot_x_tick_step(const Plot *plot) {
+    double span = plot->xmax - plot->xmin;
+    uint8_t spacing = PLOT_TICK_SPACING_X;
+    char label[PLOT_LABEL_WIDTH + 1];
+    while (true) {
+        double step = plot_tick_step(span, TFT_WIDTH, spacing);
+        int16_t widest = 0;
+        int16_t last = (int16_t) floor(plot->xmax / step);
+        for (int16_t k = (int16_t) ceil(plot->xmin / step); k <= last; k++) {
+            int16_t width = fmt_double(k * step, label, PLOT_LABEL_WIDTH) * TEXT_CHAR_WIDTH;
+            if (k && width > widest) widest = width;
         }
-    } else {
-        return 1;
+        // The step is at least spacing pixels, a wider spacing only ever
+        // follows wider labels
+        if (widest + PLOT_LABEL_GAP <= spacing || widest + PLOT_LABEL_GAP <= step * TFT_WIDTH / span) return step;
+        spacing = widest + PLOT_LABEL_GAP;
     }
-    te_free(expr);
+}
+
+// Draws the ticks on the axes and their labels. Coordinates are the viewer's
+// as in drawText, view x is the sample index. Only ticks on samples
+// [from, to) and labels reaching into them are drawn, labels that would not
+// fit entirely on screen are left out. Zero is not labelled. With erase set
+// the marks and the label boxes are cleared.
+static void plot_ticks(const Plot *plot, uint8_t from, uint8_t to, bool erase) {
+    int16_t axis_row = plot_axis_row(plot);
+    int16_t axis_col = plot_axis_col(plot);
+    uint16_t color = erase ? ST7735_BACKGROUND : ST7735_WHITE;
+    char label[PLOT_LABEL_WIDTH + 1];
+    if (axis_row >= 0) {
+        double step = plot_x_tick_step(plot);
+        // Labels go under the axis unless they do not fit there
+        int16_t axis_y = TFT_HEIGHT - 1 - axis_row;
+        int16_t label_y = axis_y + PLOT_LABEL_GAP;
+        if (label_y + TEXT_CHAR_HEIGHT > TFT_HEIGHT) label_y = axis_y - PLOT_LABEL_GAP - TEXT_CHAR_HEIGHT + 1;
+        int16_t last = (int16_t) floor(plot->xmax / step);
+        for (int16_t k = (int16_t) ceil(plot->xmin / step); k <= last; k++) {
+            if (!k) continue;
+            int16_t i = (int16_t) ((k * step - plot->xmin) * TFT_WIDTH / (plot->xmax - plot->xmin) + 0.5);
+            if (i >= from && i < to && i < TFT_WIDTH) {
+                drawFastVLine(PLOT_COL(i), axis_row - PLOT_TICK_LEN, 2 * PLOT_TICK_LEN + 1, color);
+            }
+            fmt_double(k * step, label, PLOT_LABEL_WIDTH);
+            int16_t width = textWidth(label);
+            int16_t x = i - width / 2;
+            if (x < 0 || x + width > TFT_WIDTH || x + width <= from || x >= to) continue;
+            drawText(x, label_y, label, color, ST7735_BACKGROUND);
+        }
+    }
+    if (axis_col >= 0) {
+        double step = plot_tick_step(plot->ymax - plot->ymin, TFT_HEIGHT, PLOT_TICK_SPACING_Y);
+        int16_t axis_x = TFT_WIDTH - 1 - axis_col;
+        bool tick_shown = axis_x >= from && axis_x < to;
+        int16_t last = (int16_t) floor(plot->ymax / step);
+        for (int16_t k = (int16_t) ceil(plot->ymin / step); k <= last; k++) {
+            if (!k) continue;
+            int16_t row = (int16_t) ((k * step - plot->ymin) * TFT_HEIGHT / (plot->ymax - plot->ymin));
+            if (row >= TFT_HEIGHT) continue;
+            if (tick_shown) drawFastHLine(axis_col - PLOT_TICK_LEN, row, 2 * PLOT_TICK_LEN + 1, color);
+            fmt_double(k * step, label, PLOT_LABEL_WIDTH);
+            int16_t width = textWidth(label);
+            // Right of the axis, or left of it at the right edge
+            int16_t x = axis_x + PLOT_LABEL_GAP;
+            if (x + width > TFT_WIDTH) x = axis_x - PLOT_LABEL_GAP - width + 1;
+            int16_t y = TFT_HEIGHT - 1 - row - TEXT_CHAR_HEIGHT / 2 + 1;
+            if (x < 0 || y < 0 || y + TEXT_CHAR_HEIGHT > TFT_HEIGHT || x + width <= from || x >= to) continue;
+            drawText(x, y, label, color, ST7735_BACKGROUND);
+        }
+    }
+}
+
+// Writes "a[lo,hi]" into buf, PLOT_LABEL_WIDTH * 2 + 5 bytes
+static void plot_range_line(char *buf, char axis, double lo, double hi) {
+    *buf++ = axis;
+    *buf++ = '[';
+    buf += fmt_double(lo, buf, PLOT_LABEL_WIDTH);
+    *buf++ = ',';
+    buf += fmt_double(hi, buf, PLOT_LABEL_WIDTH);
+    *buf++ = ']';
+    *buf = '\0';
+}
+
+// Draws the x and y range in the top left corner, or clears it. Returns the
+// width it takes, in samples from 0.
+static uint8_t plot_range(const Plot *plot, bool erase) {
+    char line[PLOT_LABEL_WIDTH * 2 + 5];
+    uint16_t color = erase ? ST7735_BACKGROUND : ST7735_WHITE;
+    plot_range_line(line, 'x', plot->xmin, plot->xmax);
+    int16_t width = drawText(1, 1, line, color, ST7735_BACKGROUND);
+    plot_range_line(line, 'y', plot->ymin, plot->ymax);
+    int16_t width_y = drawText(1, 1 + TEXT_CHAR_HEIGHT, line, color, ST7735_BACKGROUND);
+    if (width_y > width) width = width_y;
+    return 1 + width;
+}
+
+// Draws axes and curves of samples [from, to), including the segments that
+// join them to their neighbours, then the ticks. With erase set everything is
+// drawn in the background color instead, removing what a previous call drew.
+// Overlays are evaluated over the same samples.
+static void plot_render(Plot *plot, uint8_t from, uint8_t to, bool erase) {
+    int16_t axis_row = plot_axis_row(plot);
+    int16_t axis_col = plot_axis_col(plot);
+    uint16_t axis_color = erase ? ST7735_BACKGROUND : ST7735_WHITE;
+    if (axis_row >= 0) drawFastHLine(PLOT_COL(to - 1), axis_row, to - from, axis_color);
+    if (axis_col >= 0 && axis_col <= PLOT_COL(from) && axis_col >= PLOT_COL(to - 1)) {
+        drawFastVLine(axis_col, 0, TFT_HEIGHT, axis_color);
+    }
+    // Functions are drawn one after the other, later ones end up on top
+    for (uint8_t f = 0; f < plot->n_funcs; f++) {
+        uint16_t color = erase ? ST7735_BACKGROUND : plot_colors[f];
+#ifdef DRAW_POINTS
+        for (int i = from; i < to; i++) {
+            uint8_t y = plot_sample(plot, f, i);
+            if (y < TFT_HEIGHT) drawPixel(PLOT_COL(i), y, color);
+        }
+#else
+        int last = to < TFT_WIDTH ? to + 1 : TFT_WIDTH;
+        int i = from > 0 ? from : 1;
+        if (i >= last) continue;
+        uint8_t prev = plot_sample(plot, f, i - 1);
+        for (; i < last; i++) {
+            uint8_t y = plot_sample(plot, f, i);
+            if (plot_segment_visible(prev, y)) {
+                PROF_BEGIN(PROF_DRAWLINE);
+                drawLine(PLOT_COL(i - 1), plot_row(prev), PLOT_COL(i), plot_row(y), color);
+                PROF_END(PROF_DRAWLINE);
+            }
+            prev = y;
+        }
+#endif
+    }
+    plot_ticks(plot, from, to, erase);
+}
+
+uint8_t plot_add(Plot *plot, te_expr *expr) {
+    if (plot->n_funcs == PLOT_MAX_FUNCS) return 1;
+    plot->exprs[plot->n_funcs++] = expr;
+    // The window is kept, the new function is evaluated as it is drawn
+    if (plot_export_enabled()) {
+        plot_export_begin(plot->xmin, plot->xmax, plot->ymin, plot->ymax);
+        plot_sample_range(plot, 0, TFT_WIDTH, plot->n_funcs - 1);
+    }
+    plot_render(plot, 0, TFT_WIDTH, false);
+    plot_range(plot, false);
+    if (plot_export_enabled()) plot_export_finish(plot);
     return 0;
 }
 
+void plot_draw(Plot *plot) {
+    fillScreen(ST7735_BACKGROUND);
+    plot_render(plot, 0, TFT_WIDTH, false);
+    plot_range(plot, false);
+    if (plot_export_enabled()) plot_export_finish(plot);
+}
+
+void plot_pan(Plot *plot, int8_t cols) {
+    if (!plot->n_funcs || !cols) return;
+    // The range text stays in its corner while the picture scrolls: clear it
+    // and bring back what it covered first
+    plot_render(plot, 0, plot_range(plot, true), false);
+    uint8_t n = cols > 0 ? cols : -cols;
+    // Labels the scroll would cut at the other edge are cleared, a fresh
+    // draw leaves them out
+    if (cols > 0) {
+        plot_ticks(plot, 0, n, true);
+    } else {
+        plot_ticks(plot, TFT_WIDTH - n, TFT_WIDTH, true);
+    }
+    double dx = (plot->xmax - plot->xmin) / TFT_WIDTH;
+    plot->xmin += cols * dx;
+    plot->xmax += cols * dx;
+    // Keep the samples still on screen, only the exposed ones are evaluated
+    uint8_t from, to;
+    if (cols > 0) {
+        memmove(plot->y_vals, plot->y_vals + n, TFT_WIDTH - n);
+        from = TFT_WIDTH - n;
+        to = TFT_WIDTH;
+    } else {
+        memmove(plot->y_vals + n, plot->y_vals, TFT_WIDTH - n);
+        from = 0;
+        to = n;
+    }
+    if (plot_export_enabled()) plot_export_begin(plot->xmin, plot->xmax, plot->ymin, plot->ymax);
+    plot_sample_range(plot, from, to, 0);
+    // Move the picture in hardware instead of repainting it, then clear and
+    // draw only the exposed columns
+    setScrollOffset((getScrollOffset() + TFT_WIDTH - cols) % TFT_WIDTH);
+    fillRect(PLOT_COL(to - 1), 0, n, TFT_HEIGHT, ST7735_BACKGROUND);
+    // Labels near the exposed columns were left out while they did not fit,
+    // so the strip is redrawn a label wide. So is the other edge, where
+    // labels were cleared before scrolling.
+    plot_render(plot, from > PLOT_LABEL_SPAN ? from - PLOT_LABEL_SPAN : 0,
+                to < TFT_WIDTH - PLOT_LABEL_SPAN ? to + PLOT_LABEL_SPAN : TFT_WIDTH, false);
+    if (cols > 0) {
+        plot_render(plot, 0, PLOT_LABEL_SPAN, false);
+    } else {
+        plot_render(plot, TFT_WIDTH - PLOT_LABEL_SPAN, TFT_WIDTH, false);
+    }
+    plot_range(plot, false);
+    if (plot_export_enabled()) plot_export_finish(plot);
+}
+
+void plot_zoom(Plot *plot, bool zoom_in) {
+    if (!plot->n_funcs) return;
+    // Erase the curves, axes and labels in place, much cheaper than a fillScreen
+    plot_range(plot, true);
+    plot_render(plot, 0, TFT_WIDTH, true);
+    double center = (plot->xmin + plot->xmax) / 2;
+    double half = (plot->xmax - plot->xmin) / 2;
+    half = zoom_in ? half / 2 : half * 2;
+    plot->xmin = center - half;
+    plot->xmax = center + half;
+    // Samples sit at center + (i - W/2) * dx, so every other old sample lands
+    // exactly on a new one. The copy order never reads an overwritten sample.
+    const uint8_t mid = TFT_WIDTH / 2;
+    uint8_t *y = plot->y_vals;
+    if (zoom_in) {
+        // new[i] = old[mid/2 + i/2] for even i
+        for (int16_t i = TFT_WIDTH - 2; i >= mid; i -= 2) y[i] = y[mid / 2 + i / 2];
+        for (int16_t i = 0; i < mid; i += 2) y[i] = y[mid / 2 + i / 2];
+    } else {
+        // new[i] = old[2i - mid] for i in [mid/2, 3mid/2)
+        for (int16_t i = mid - 1; i >= mid / 2; i--) y[i] = y[2 * i - mid];
+        for (int16_t i = mid; i < mid + mid / 2; i++) y[i] = y[2 * i - mid];
+    }
+    if (plot_export_enabled()) plot_export_begin(plot->xmin, plot->xmax, plot->ymin, plot->ymax);
+    if (zoom_in) {
+        for (uint8_t i = 1; i < TFT_WIDTH; i += 2) plot_sample_range(plot, i, i + 1, 0);
+    } else {
+        plot_sample_range(plot, 0, mid / 2, 0);
+        plot_sample_range(plot, mid + mid / 2, TFT_WIDTH, 0);
+    }
+    plot_render(plot, 0, TFT_WIDTH, false);
+    plot_range(plot, false);
+    if (plot_export_enabled()) plot_export_finish(plot);
+}
+
 Node * init_keypad(void){
     Node *head;
     head = (Node*)malloc(sizeof(Node));
     head->next=NULL;
     
-	DDRD |= (1<<2)  | (1<<3) | (1<<4) | (1<<5);
+	DDRD |= KEYPAD_COLS_D;
+	KEYPAD_COL2_DDR |= KEYPAD_COL2;
 	DDRC |=  (1<<0) | (1<<1) | (1<<2) | (1<<3);
 	PORTD |= (1<<6) | (1<<7);
 	PORTB |= (1<<0) | (1<<1);
 	
 	PCICR |= (1<<PCIE0)    | (1<<PCIE1)   | (1<<PCIE2);
-	PCMSK2 |= (1<<PCINT18) | (1<<PCINT19) | (1<<PCINT20) | (1<<PCINT21) | (1<<PCINT22) | (1<<PCINT23);
+	PCMSK2 |= KEYPAD_COLS_D | (1<<PCINT22) | (1<<PCINT23);
+	KEYPAD_COL2_PCMSK |= KEYPAD_COL2;
 	PCMSK1 |= (1<<PCINT8)  | (1<<PCINT9)  | (1<<PCINT10) | (1<<PCINT11);
 	PCMSK0 |= (1<<PCINT0)  | (1<<PCINT1);
     
@@ -79,6 +477,15 @@ void append(char* val, Node * cabeza){
     current->next->next=NULL;
 }
 
+// Node of the last value appended, the list must not be empty
+Node * last_node(Node * cabeza){
+    Node *current = cabeza;
+    while (current->next->next != NULL){
+        current = current->next;
+    }
+    return current;
+}
+
 char * decode(Node * cabeza, char count){
     Node * current = cabeza;
     char * string = (char *)malloc(count);
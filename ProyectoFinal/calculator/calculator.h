@@ -3,16 +3,23 @@
 
 #define F_CPU	16000000UL
 
+//#define DRAW_POINTS
+
 #include <util/delay.h>
 #include <stdint.h>
 #include <avr/io.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
 
 #include "../display/ST7735_commands.h"
 #include "../display/graphic_shapes.h"
 #include "../tinyexpr/tinyexpr.h"
 #include "../usart/usart.h"
+#include "../prof/prof.h"
+#include "../fmt/fmt.h"
+#include "plot_export.h"
+#include "tabulate.h"
 
 typedef struct node{
     char valor;
@@ -21,10 +28,91 @@ typedef struct node{
 
 Node * init_keypad(void);
 void append(char* valor, Node* cabeza);
+Node * last_node(Node* cabeza);
 char * decode(Node* cabeza, char count);
 
 uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b);
 void drawMajorAxes(uint16_t color);
-uint8_t calculateFunctionPixels(uint8_t *y_vals, char *expression, double range);
+
+// Maximum number of functions overlaid in one plot
+#define PLOT_MAX_FUNCS 3
+// Screen column of sample i. The panel is mounted rotated, sample 0 is on the right edge.
+#define PLOT_COL(i) (TFT_WIDTH - 1 - (i))
+
+// Columns moved per pan key press
+#define PLOT_PAN_STEP 16
+// Least pixels between axis ticks, the step is the next 1, 2 or 5 times a power of ten
+#define PLOT_TICK_SPACING_X 32
+#define PLOT_TICK_SPACING_Y 20
+// Tick mark length on each side of the axis, and the gap to its label
+#define PLOT_TICK_LEN 2
+#define PLOT_LABEL_GAP 3
+// Characters of a tick label or of a bound in the range text, the least
+// fmt_double takes
+#define PLOT_LABEL_WIDTH FMT_MIN_WIDTH
+// Widest label in pixels
+#define PLOT_LABEL_SPAN (PLOT_LABEL_WIDTH * TEXT_CHAR_WIDTH)
+// y_vals markers for samples that fall outside the window or are undefined
+#define PLOT_Y_BELOW 0xFD
+#define PLOT_Y_ABOVE 0xFE
+#define PLOT_Y_NAN   0xFF
+
+typedef struct plot {
+    te_expr *exprs[PLOT_MAX_FUNCS];
+    Tabulation *tab;                            // Set while exprs[0] is served from the table
+    uint8_t n_funcs;
+    double real_x;                              // Bound to "x" in every expression
+    double xmin, xmax;                          // Sample i is at xmin + (xmax - xmin) * i / TFT_WIDTH
+    double ymin, ymax;                          // Mapped to pixel rows 0 and TFT_HEIGHT
+    // Pixel row of each sample of the first function or a PLOT_Y_* marker.
+    // Overlays keep no samples, they are evaluated again as they are drawn.
+    uint8_t y_vals[TFT_WIDTH];
+} Plot;
+
+extern const uint16_t plot_colors[PLOT_MAX_FUNCS];
+
+// Compiles a comma separated list of up to PLOT_MAX_FUNCS functions of x,
+// replacing the previous plot. The expression string is split in place.
+// Returns 0 on success.
+uint8_t plot_compile(Plot *plot, char *expression);
+void plot_free(Plot *plot);
+// Samples the first function over [xmin, xmax]. With autoscale the y window
+// is fit to all functions in an extra pass, otherwise [ymin, ymax] is used as
+// is and samples outside of it are clipped. Returns 0 on success.
+uint8_t calculateFunctionPixels(Plot *plot, double xmin, double xmax, double ymin, double ymax, bool autoscale);
+// Real x coordinate of sample i
+double plot_x(const Plot *plot, int16_t i);
+// Pixel row of sample i of function f or a PLOT_Y_* marker, from y_vals for
+// the first function and evaluated for the others
+uint8_t plot_sample(Plot *plot, uint8_t f, uint8_t i);
+// Drawing row of a y_vals entry, just outside the screen for clipped samples.
+int16_t plot_row(uint8_t y_val);
+// Whether the segment between two neighbouring samples is drawn.
+bool plot_segment_visible(uint8_t y0, uint8_t y1);
+// Screen column of x = 0 and row of y = 0, -1 when outside the window.
+int16_t plot_axis_col(const Plot *plot);
+int16_t plot_axis_row(const Plot *plot);
+// Fits the first function to the piecewise cubic table over twice the
+// window, so panning, zooming out once and the solvers skip the tree. The
+// error bound is a quarter of a pixel row. Returns the number of segments
+// fitted.
+uint8_t plot_tabulate(Plot *plot);
+// Puts the original trees back.
+void plot_untabulate(Plot *plot);
+// Tree function f was compiled to, whether tabulated or not.
+te_expr *plot_source(const Plot *plot, uint8_t f);
+// Overlays an already compiled function of plot->real_x on the current
+// window, the plot takes ownership. Returns 1 if the plot is full.
+uint8_t plot_add(Plot *plot, te_expr *expr);
+// Clears the screen and draws the axes with labelled ticks, every function in
+// its own color and the x and y range in the top left corner.
+void plot_draw(Plot *plot);
+// Moves the window by cols samples (positive towards larger x). The picture
+// is scrolled in hardware and only the exposed samples of the first function
+// are evaluated, overlays also along the strips redrawn for labels.
+void plot_pan(Plot *plot, int8_t cols);
+// Halves or doubles the window around its center, reusing every other sample
+// of the first function.
+void plot_zoom(Plot *plot, bool zoom_in);
 
 #endif /* CUSTOMROUTINES_H_ */
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "curve.h"
+#include "calculator.h"
+#include <math.h>
+
+// Fraction of the window left around an autoscaled curve, on each side
+#define CURVE_MARGIN 0.05
+
+// Point of the curve in sample (column index) and row units
+typedef struct curve_point {
+    double i, row;
+    bool valid;             // The curve is defined there
+} CurvePoint;
+
+uint8_t curve_compile(Curve *curve, char *expression) {
+    te_variable vars[] = {{"t", &curve->real_t}};
+    curve_free(curve);
+    // A top level comma separates x(t) from y(t)
+    char *second = NULL;
+    uint8_t depth = 0;
+    for (char *c = expression; *c; c++) {
+        if (*c == '(') depth++;
+        if (*c == ')' && depth) depth--;
+        if (*c == ',' && !depth) {
+            if (second) return 1;
+            *c = '\0';
+            second = c + 1;
+        }
+    }
+    int err = 0;
+    PROF_BEGIN(PROF_TE_COMPILE);
+    curve->fx = te_compile(expression, vars, 1, &err);
+    if (curve->fx && second) curve->fy = te_compile(second, vars, 1, &err);
+    PROF_END(PROF_TE_COMPILE);
+    if (!curve->fx || (second && !curve->fy)) {
+        curve_free(curve);
+        return err ? err : 1;
+    }
+    return 0;
+}
+
+void curve_free(Curve *curve) {
+    te_free(curve->fx);
+    te_free(curve->fy);
+    curve->fx = NULL;
+    curve->fy = NULL;
+}
+
+// Real coordinates of the curve at t
+static void curve_eval(Curve *curve, double t, double *x, double *y) {
+    curve->real_t = t;
+    PROF_BEGIN(PROF_TE_EVAL);
+    *x = te_eval(curve->fx);
+    if (curve->fy) {
+        *y = te_eval(curve->fy);
+    } else {
+        *y = *x * sin(t);
+        *x *= cos(t);
+    }
+    PROF_END(PROF_TE_EVAL);
+    curve->evals++;
+}
+
+static CurvePoint curve_point(Curve *curve, double t) {
+    double x, y;
+    CurvePoint p;
+    curve_eval(curve, t, &x, &y);
+    p.i = (x - curve->xmin) * TFT_WIDTH / (curve->xmax - curve->xmin);
+    p.row = (y - curve->ymin) * TFT_HEIGHT / (curve->ymax - curve->ymin);
+    p.valid = isfinite(p.i) && isfinite(p.row);
+    return p;
+}
+
+// Whether three points are all past the same edge of the screen, so the
+// curve between them can be left out without refining it
+static bool curve_outside(const CurvePoint *a, const CurvePoint *b, const CurvePoint *m) {
+    return (a->i < 0 && b->i < 0 && m->i < 0)
+        || (a->i >= TFT_WIDTH && b->i >= TFT_WIDTH && m->i >= TFT_WIDTH)
+        || (a->row < 0 && b->row < 0 && m->row < 0)
+        || (a->row >= TFT_HEIGHT && b->row >= TFT_HEIGHT && m->row >= TFT_HEIGHT);
+}
+
+// Fits the window around CURVE_SCALE_SAMPLES points, with square pixels
+static uint8_t curve_autoscale(Curve *curve) {
+    double xlo = INFINITY, xhi = -INFINITY, ylo = INFINITY, yhi = -INFINITY;
+    for (uint8_t s = 0; s <= CURVE_SCALE_SAMPLES; s++) {
+        double x, y;
+        curve_eval(curve, curve->tmin + (curve->tmax - curve->tmin) * s / CURVE_SCALE_SAMPLES, &x, &y);
+        if (!isfinite(x) || !isfinite(y)) continue;
+        if (x < xlo) xlo = x;
+        if (x > xhi) xhi = x;
+        if (y < ylo) ylo = y;
+        if (y > yhi) yhi = y;
+    }
+    if (!(xlo <= xhi)) return 1;
+    // Real units per pixel, the larger of both axes
+    double scale = (xhi - xlo) / TFT_WIDTH;
+    if ((yhi - ylo) / TFT_HEIGHT > scale) scale = (yhi - ylo) / TFT_HEIGHT;
+    if (scale == 0) scale = 2.0 / TFT_HEIGHT;
+    scale *= 1 + 2 * CURVE_MARGIN;
+    double cx = (xlo + xhi) / 2, cy = (ylo + yhi) / 2;
+    curve->xmin = cx - scale * TFT_WIDTH / 2;
+    curve->xmax = cx + scale * TFT_WIDTH / 2;
+    curve->ymin = cy - scale * TFT_HEIGHT / 2;
+    curve->ymax = cy + scale * TFT_HEIGHT / 2;
+    return 0;
+}
+
+static void curve_axes(const Curve *curve) {
+    if (curve->xmin <= 0 && curve->xmax >= 0) {
+        int16_t i = (int16_t) (-curve->xmin * TFT_WIDTH / (curve->xmax - curve->xmin) + 0.5);
+        if (i < TFT_WIDTH) drawFastVLine(PLOT_COL(i), 0, TFT_HEIGHT, ST7735_WHITE);
+    }
+    if (curve->ymin <= 0 && curve->ymax >= 0) {
+        int16_t row = (int16_t) (-curve->ymin * TFT_HEIGHT / (curve->ymax - curve->ymin));
+        if (row < TFT_HEIGHT) drawFastHLine(0, row, TFT_WIDTH, ST7735_WHITE);
+    }
+}
+
+// Moves the pen to p, drawing from the previous point unless the pen is up
+// or p is on the same pixel
+static void curve_line_to(CurvePoint *pen, const CurvePoint *p) {
+    int16_t i0 = (int16_t) lround(pen->i), r0 = (int16_t) lround(pen->row);
+    int16_t i1 = (int16_t) lround(p->i), r1 = (int16_t) lround(p->row);
+    if (pen->valid && i0 == i1 && r0 == r1) return;
+    if (pen->valid) {
+        PROF_BEGIN(PROF_DRAWLINE);
+        drawLine(PLOT_COL(i0), r0, PLOT_COL(i1), r1, plot_colors[0]);
+        PROF_END(PROF_DRAWLINE);
+    }
+    *pen = *p;
+}
+
+// Walks t from tmin to tmax in steps adapted to the screen length of the
+// curve, joining the points with straight lines. Every step evaluates its
+// end and its midpoint, and is drawn through both once accepted.
+static void curve_render(Curve *curve) {
+    double span = curve->tmax - curve->tmin;
+    double dt_max = span / CURVE_START_STEPS, dt_min = span / CURVE_MIN_STEP_DIV;
+    double t = curve->tmin, dt = dt_max;
+    CurvePoint a = curve_point(curve, t), b, m;
+    // Last point drawn to, the pen is up while it is not valid
+    CurvePoint pen = a;
+    bool have_b = false;
+    while (t < curve->tmax && curve->evals < CURVE_MAX_EVALS) {
+        if (dt >= curve->tmax - t) {
+            dt = curve->tmax - t;
+            have_b = false;
+        }
+        if (!have_b) b = curve_point(curve, t + dt);
+        m = curve_point(curve, t + dt / 2);
+        bool split = false;
+        double len = 0, bend = 0;
+        if (a.valid && b.valid && m.valid) {
+            len = hypot(m.i - a.i, m.row - a.row) + hypot(b.i - m.i, b.row - m.row);
+            bend = hypot(m.i - (a.i + b.i) / 2, m.row - (a.row + b.row) / 2);
+            split = (len > 2 * CURVE_MAX_SEG || bend > CURVE_MAX_BEND) && !curve_outside(&a, &b, &m);
+        } else {
+            // Narrow down where the curve starts or stops being defined
+            split = a.valid || b.valid || m.valid;
+        }
+        if (split && dt > dt_min) {
+            // The midpoint is the end of the next try
+            b = m;
+            have_b = true;
+            dt /= 2;
+            continue;
+        }
+        t += dt;
+        have_b = false;
+        if (!b.valid || !a.valid || !m.valid || len > 2 * CURVE_MAX_SEG || curve_outside(&a, &b, &m)) {
+            // Undefined, off screen, or a jump left after the smallest step
+            pen = b;
+        } else {
+            curve_line_to(&pen, &m);
+            curve_line_to(&pen, &b);
+        }
+        a = b;
+        // Short and straight: try a longer step
+        if (len < CURVE_MAX_SEG && bend < CURVE_MAX_BEND / 4 && dt * 2 <= dt_max) dt *= 2;
+    }
+}
+
+uint8_t curve_draw(Curve *curve, double tmin, double tmax, double xmin, double xmax,
+                   double ymin, double ymax, bool autoscale) {
+    if (!curve->fx || tmin >= tmax) return 1;
+    curve->tmin = tmin;
+    curve->tmax = tmax;
+    curve->evals = 0;
+    if (autoscale) {
+        if (curve_autoscale(curve)) return 1;
+    } else {
+        if (xmin >= xmax || ymin >= ymax) return 1;
+        curve->xmin = xmin;
+        curve->xmax = xmax;
+        curve->ymin = ymin;
+        curve->ymax = ymax;
+    }
+    fillScreen(ST7735_BACKGROUND);
+    curve_axes(curve);
+    curve_render(curve);
+    return 0;
+}
@@ -0,0 +1,47 @@
+#ifndef CURVE_H_
+#define CURVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../tinyexpr/tinyexpr.h"
+
+// Curves of a parameter t: parametric (x(t), y(t)) or polar r(t). Instead of
+// a fixed number of samples, the step in t is adapted to the length of the
+// curve on screen. A step is halved while either half spans more than about
+// CURVE_MAX_SEG pixels or its midpoint is more than CURVE_MAX_BEND pixels off
+// the straight line, and doubled again once the curve is short and straight.
+// Points on the pixel of the previous one are not drawn.
+// Longest segment drawn with drawLine, in pixels
+#define CURVE_MAX_SEG 4
+// Largest distance of the midpoint of a step from the middle of its segment, in pixels
+#define CURVE_MAX_BEND 1.0
+// Steps of the first try, and the most a step is split into
+#define CURVE_START_STEPS 64
+#define CURVE_MIN_STEP_DIV 65536UL
+// Bound on the evaluations of one draw
+#define CURVE_MAX_EVALS 6000
+// Samples of the pass that fits the window to the curve
+#define CURVE_SCALE_SAMPLES 128
+
+typedef struct curve {
+    te_expr *fx;            // x(t), or r(t) for a polar curve. NULL when none is compiled.
+    te_expr *fy;            // y(t), NULL for a polar curve
+    double real_t;          // Bound to "t" in both
+    double tmin, tmax;
+    double xmin, xmax;      // Mapped to samples 0 and TFT_WIDTH, as in a plot
+    double ymin, ymax;      // Mapped to pixel rows 0 and TFT_HEIGHT
+    uint16_t evals;         // Evaluations of the last draw
+} Curve;
+
+// Compiles "r" as a polar curve or "x,y" as a parametric one, replacing the
+// previous curve. The expression string is split in place. Returns 0 on success.
+uint8_t curve_compile(Curve *curve, char *expression);
+void curve_free(Curve *curve);
+// Clears the screen and draws the curve for t in [tmin, tmax]. With autoscale
+// the window is fit to the curve with the same scale on both axes, otherwise
+// [xmin, xmax] x [ymin, ymax] is used. Returns 0 on success, 1 when the curve
+// is undefined everywhere or the ranges are empty.
+uint8_t curve_draw(Curve *curve, double tmin, double tmax, double xmin, double xmax,
+                   double ymin, double ymax, bool autoscale);
+
+#endif /* CURVE_H_ */
@@ -0,0 +1,298 @@
+#include "grid.h"
+#include "calculator.h"
+#include <math.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_word(addr) (*(addr))
+#endif
+
+#define GRID_COLS (TFT_WIDTH / GRID_STEP + 1)
+#define GRID_ROWS (TFT_HEIGHT / GRID_STEP + 1)
+// Grid points per axis between the samples of the heatmap range pass
+#define GRID_RANGE_STRIDE 4
+
+// Dependencies of a subtree
+#define GRID_DEP_X 0x01
+#define GRID_DEP_Y 0x02
+#define GRID_DEP_ALL 0x04   // Calls a function with state, never hoisted
+
+// Viridis in RGB565, low values dark blue
+static const uint16_t grid_palette[GRID_PALETTE_SIZE] PROGMEM = {
+    0x400A, 0x48CD, 0x416F, 0x4230, 0x3AB1, 0x3351, 0x2BD1, 0x2451,
+    0x1CD1, 0x2550, 0x35AF, 0x562D, 0x7E8A, 0xA6C6, 0xD703, 0xFF24
+};
+
+// Marching squares segments per corner case, as pairs of cell edges
+// (first << 2 | second), up to two pairs per case, 0 for none. Corners are
+// bit 0 at (x, y), bit 1 at (x + 1, y), bit 2 at (x + 1, y + 1) and bit 3 at
+// (x, y + 1). Edges are 0 bottom, 1 right, 2 top and 3 left, edge n runs
+// from corner n to the next one. The saddles 5 and 10 list the split for a
+// center on the same side as corner 0, saddle_split is the other one.
+#define SEG(A, B) ((A) << 2 | (B))
+static const uint8_t contour_segments[16][2] = {
+    {0, 0}, {SEG(3, 0), 0}, {SEG(0, 1), 0}, {SEG(3, 1), 0},
+    {SEG(1, 2), 0}, {SEG(0, 1), SEG(2, 3)}, {SEG(0, 2), 0}, {SEG(3, 2), 0},
+    {SEG(2, 3), 0}, {SEG(0, 2), 0}, {SEG(0, 1), SEG(2, 3)}, {SEG(1, 2), 0},
+    {SEG(3, 1), 0}, {SEG(0, 1), 0}, {SEG(3, 0), 0}, {0, 0}
+};
+static const uint8_t saddle_split[2] = {SEG(3, 0), SEG(1, 2)};
+
+static uint8_t grid_arity(const te_expr *n) {
+    return (n->type & (TE_FUNCTION0 | TE_CLOSURE0)) ? n->type & 7 : 0;
+}
+
+static void grid_add_hoist(Grid *grid, te_expr **site, uint8_t deps) {
+    if (grid->n_hoists == GRID_MAX_HOIST) return;
+    GridHoist *h = &grid->hoists[grid->n_hoists];
+    te_variable vars[] = {{"h", &h->value, TE_VARIABLE, 0}};
+    te_expr *var = te_compile("h", vars, 1, 0);
+    if (!var) return;
+    h->site = site;
+    h->subtree = *site;
+    h->per_column = deps == GRID_DEP_X;
+    *site = var;
+    grid->n_hoists++;
+}
+
+// Returns what n depends on. Below a node that depends on both x and y, the
+// largest subtrees of a single variable are replaced by a variable node
+// whose value is updated once per row or column.
+static uint8_t grid_hoist(Grid *grid, te_expr *n) {
+    uint8_t arity = grid_arity(n);
+    if (!(n->type & (TE_FUNCTION0 | TE_CLOSURE0))) {
+        // Constants and variables other than x and y do not change during a draw
+        if ((n->type & 0x1F) != TE_VARIABLE) return 0;
+        if (n->bound == &grid->real_x) return GRID_DEP_X;
+        if (n->bound == &grid->real_y) return GRID_DEP_Y;
+        return 0;
+    }
+    uint8_t deps[7];
+    uint8_t all = 0;
+    for (uint8_t i = 0; i < arity; i++) {
+        deps[i] = grid_hoist(grid, n->parameters[i]);
+        all |= deps[i];
+    }
+    if (!(n->type & TE_FLAG_PURE)) all |= GRID_DEP_ALL;
+    if (all != 0 && all != GRID_DEP_X && all != GRID_DEP_Y) {
+        for (uint8_t i = 0; i < arity; i++) {
+            te_expr *child = n->parameters[i];
+            // Leaves cost as much as the variable that would replace them
+            if (!grid_arity(child)) continue;
+            if (deps[i] == 0 || deps[i] == GRID_DEP_X || deps[i] == GRID_DEP_Y) {
+                grid_add_hoist(grid, (te_expr **) &n->parameters[i], deps[i]);
+            }
+        }
+    }
+    return all;
+}
+
+uint8_t grid_compile(Grid *grid, const char *expression) {
+    te_variable vars[] = {{"x", &grid->real_x, TE_VARIABLE, 0}, {"y", &grid->real_y, TE_VARIABLE, 0}};
+    grid_free(grid);
+    int err = 0;
+    PROF_BEGIN(PROF_TE_COMPILE);
+    grid->expr = te_compile(expression, vars, 2, &err);
+    PROF_END(PROF_TE_COMPILE);
+    if (!grid->expr) return err ? err : 1;
+    grid_hoist(grid, grid->expr);
+    return 0;
+}
+
+void grid_free(Grid *grid) {
+    for (uint8_t h = 0; h < grid->n_hoists; h++) {
+        te_expr *var = *grid->hoists[h].site;
+        *grid->hoists[h].site = grid->hoists[h].subtree;
+        te_free(var);
+    }
+    grid->n_hoists = 0;
+    te_free(grid->expr);
+    grid->expr = NULL;
+}
+
+static double grid_x(const Grid *grid, uint8_t j) {
+    return grid->xmin + (grid->xmax - grid->xmin) * j * GRID_STEP / TFT_WIDTH;
+}
+
+// Moves to grid row k, evaluating the subtrees that only depend on y
+static void grid_set_row(Grid *grid, uint8_t k) {
+    grid->real_y = grid->ymin + (grid->ymax - grid->ymin) * k * GRID_STEP / TFT_HEIGHT;
+    for (uint8_t h = 0; h < grid->n_hoists; h++) {
+        if (!grid->hoists[h].per_column) grid->hoists[h].value = te_eval(grid->hoists[h].subtree);
+    }
+}
+
+// Evaluates f at column j of the current row. cache holds the per column
+// subtrees of every column, without it they are evaluated in place.
+static double grid_point(Grid *grid, uint8_t j, const float *cache) {
+    grid->real_x = grid_x(grid, j);
+    for (uint8_t h = 0; h < grid->n_hoists; h++) {
+        GridHoist *hoist = &grid->hoists[h];
+        if (!hoist->per_column) continue;
+        hoist->value = cache ? *cache++ : te_eval(hoist->subtree);
+    }
+    return te_eval(grid->expr);
+}
+
+static uint8_t grid_column_hoists(const Grid *grid) {
+    uint8_t n = 0;
+    for (uint8_t h = 0; h < grid->n_hoists; h++) n += grid->hoists[h].per_column;
+    return n;
+}
+
+// Values of the per column subtrees, n_cached per column. NULL when there
+// are none or no memory for them.
+static float *grid_fill_cache(Grid *grid, uint8_t n_cached) {
+    if (!n_cached) return NULL;
+    float *cache = malloc(GRID_COLS * n_cached * sizeof(float));
+    if (!cache) return NULL;
+    float *c = cache;
+    for (uint8_t j = 0; j < GRID_COLS; j++) {
+        grid->real_x = grid_x(grid, j);
+        for (uint8_t h = 0; h < grid->n_hoists; h++) {
+            if (grid->hoists[h].per_column) *c++ = te_eval(grid->hoists[h].subtree);
+        }
+    }
+    return cache;
+}
+
+static void grid_axes(const Grid *grid) {
+    if (grid->xmin <= 0 && grid->xmax >= 0) {
+        int16_t i = (int16_t) (-grid->xmin * TFT_WIDTH / (grid->xmax - grid->xmin) + 0.5);
+        if (i < TFT_WIDTH) drawFastVLine(PLOT_COL(i), 0, TFT_HEIGHT, ST7735_WHITE);
+    }
+    if (grid->ymin <= 0 && grid->ymax >= 0) {
+        int16_t row = (int16_t) (-grid->ymin * TFT_HEIGHT / (grid->ymax - grid->ymin));
+        if (row < TFT_HEIGHT) drawFastHLine(0, row, TFT_WIDTH, ST7735_WHITE);
+    }
+}
+
+// Streams each band of GRID_STEP rows straight into the controller, colored
+// by the value of f at its grid points. The color scale spans the values of
+// a coarse pass over the grid, outliers take the end colors.
+static uint8_t grid_heatmap(Grid *grid, const float *cache, uint8_t n_cached) {
+    uint8_t *shades = malloc(GRID_COLS);
+    if (!shades) return 1;
+    double lo = INFINITY, hi = -INFINITY;
+    for (uint8_t k = 0; k < GRID_ROWS; k += GRID_RANGE_STRIDE) {
+        grid_set_row(grid, k);
+        for (uint8_t j = 0; j < GRID_COLS; j += GRID_RANGE_STRIDE) {
+            double v = grid_point(grid, j, cache ? cache + j * n_cached : NULL);
+            if (!isfinite(v)) continue;
+            if (v < lo) lo = v;
+            if (v > hi) hi = v;
+        }
+    }
+    if (!(lo < hi)) {
+        // Constant or undefined everywhere sampled
+        lo = isfinite(lo) ? lo - 1 : -1;
+        hi = lo + 2;
+    }
+    double scale = (GRID_PALETTE_SIZE - 1) / (hi - lo);
+    for (uint8_t k = 0; k < TFT_HEIGHT / GRID_STEP; k++) {
+        grid_set_row(grid, k);
+        for (uint8_t j = 0; j < TFT_WIDTH / GRID_STEP; j++) {
+            PROF_BEGIN(PROF_TE_EVAL);
+            double v = grid_point(grid, j, cache ? cache + j * n_cached : NULL);
+            PROF_END(PROF_TE_EVAL);
+            double shade = (v - lo) * scale + 0.5;
+            if (shade != shade) shades[j] = 0xFF;
+            else if (shade < 0) shades[j] = 0;
+            else if (shade >= GRID_PALETTE_SIZE) shades[j] = GRID_PALETTE_SIZE - 1;
+            else shades[j] = (uint8_t) shade;
+        }
+        // RAM column 0 shows the last sample of the row
+        setAddrWindow(0, k * GRID_STEP, TFT_WIDTH - 1, k * GRID_STEP + GRID_STEP - 1);
+        for (uint8_t r = 0; r < GRID_STEP; r++) {
+            for (int16_t i = TFT_WIDTH - 1; i >= 0; i--) {
+                uint8_t s = shades[i / GRID_STEP];
+                pushColor(s == 0xFF ? ST7735_BACKGROUND : pgm_read_word(&grid_palette[s]));
+            }
+        }
+    }
+    free(shades);
+    return 0;
+}
+
+// Screen point where f crosses an edge of cell (j, k), by linear interpolation
+static void grid_edge_point(uint8_t edge, uint8_t j, uint8_t k, const float *v, int16_t *col, int16_t *row) {
+    // Corner values, counterclockwise from (j, k)
+    float a = v[edge], b = v[(edge + 1) & 3];
+    float t = a / (a - b);
+    float i = j, r = k;
+    switch (edge) {
+        case 0: i += t; break;
+        case 1: i += 1; r += t; break;
+        case 2: i += 1 - t; r += 1; break;
+        default: r += 1 - t; break;
+    }
+    *col = PLOT_COL((int16_t) (i * GRID_STEP + 0.5f));
+    *row = (int16_t) (r * GRID_STEP + 0.5f);
+}
+
+// Traces f = 0 through every cell whose corners change sign
+static uint8_t grid_contour(Grid *grid, const float *cache, uint8_t n_cached) {
+    float *rows = malloc(2 * GRID_COLS * sizeof(float));
+    if (!rows) return 1;
+    float *below = rows, *above = rows + GRID_COLS;
+    fillScreen(ST7735_BACKGROUND);
+    grid_axes(grid);
+    for (uint8_t k = 0; k < GRID_ROWS; k++) {
+        grid_set_row(grid, k);
+        for (uint8_t j = 0; j < GRID_COLS; j++) {
+            PROF_BEGIN(PROF_TE_EVAL);
+            above[j] = grid_point(grid, j, cache ? cache + j * n_cached : NULL);
+            PROF_END(PROF_TE_EVAL);
+        }
+        for (uint8_t j = 0; k && j + 1 < GRID_COLS; j++) {
+            float v[4] = {below[j], below[j + 1], above[j + 1], above[j]};
+            uint8_t c = 0;
+            bool undefined = false;
+            for (uint8_t n = 0; n < 4; n++) {
+                if (v[n] != v[n]) undefined = true;
+                if (v[n] > 0) c |= 1 << n;
+            }
+            // Cells touching an undefined point are left out
+            if (undefined) continue;
+            const uint8_t *segs = contour_segments[c];
+            if (segs[1] && (v[0] + v[1] + v[2] + v[3] > 0) != (v[0] > 0)) segs = saddle_split;
+            for (uint8_t s = 0; s < 2 && segs[s]; s++) {
+                int16_t c0, r0, c1, r1;
+                grid_edge_point(segs[s] >> 2, j, k - 1, v, &c0, &r0);
+                grid_edge_point(segs[s] & 3, j, k - 1, v, &c1, &r1);
+                PROF_BEGIN(PROF_DRAWLINE);
+                drawLine(c0, r0, c1, r1, plot_colors[0]);
+                PROF_END(PROF_DRAWLINE);
+            }
+        }
+        float *t = below;
+        below = above;
+        above = t;
+    }
+    free(rows);
+    return 0;
+}
+
+uint8_t grid_draw(Grid *grid, double xmin, double xmax, double ymin, double ymax, uint8_t mode) {
+    if (!grid->expr || xmin >= xmax || ymin >= ymax) return 1;
+    grid->xmin = xmin;
+    grid->xmax = xmax;
+    grid->ymin = ymin;
+    grid->ymax = ymax;
+    grid->mode = mode;
+    // Rows are streamed in RAM coordinates
+    setScrollOffset(0);
+    uint8_t n_cached = grid_column_hoists(grid);
+    float *cache = grid_fill_cache(grid, n_cached);
+    uint8_t err;
+    if (mode == GRID_CONTOUR) {
+        err = grid_contour(grid, cache, n_cached);
+    } else {
+        err = grid_heatmap(grid, cache, n_cached);
+        if (!err) grid_axes(grid);
+    }
+    free(cache);
+    return err;
+}
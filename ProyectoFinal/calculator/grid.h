@@ -0,0 +1,53 @@
+#ifndef GRID_H_
+#define GRID_H_
+
+#include <stdint.h>
+#include "../tinyexpr/tinyexpr.h"
+
+// Plots of f(x, y) over the screen: a heatmap of its value, or the implicit
+// curve f(x, y) = 0 traced with marching squares. f is evaluated on a grid of
+// one point every GRID_STEP pixels, row by row. Subtrees that only depend on
+// y are evaluated once per row, and subtrees that only depend on x once per
+// column, their values cached for every row.
+#ifndef GRID_STEP
+#ifdef __AVR__
+#define GRID_STEP 2
+#else
+#define GRID_STEP 1
+#endif
+#endif
+// Subtrees of one variable taken out of the tree
+#define GRID_MAX_HOIST 4
+#define GRID_PALETTE_SIZE 16
+
+enum grid_mode {
+    GRID_HEATMAP,
+    GRID_CONTOUR
+};
+
+typedef struct grid_hoist {
+    te_expr **site;         // Parameter of the parent the subtree was taken from
+    te_expr *subtree;       // Original subtree, its value goes to value
+    double value;           // Bound to the variable node now at *site
+    uint8_t per_column;     // Depends on x, otherwise on y or nothing
+} GridHoist;
+
+typedef struct grid {
+    te_expr *expr;          // NULL when no function is compiled
+    double real_x, real_y;  // Bound to "x" and "y"
+    double xmin, xmax;      // Grid column j is at sample j * GRID_STEP, as in a plot
+    double ymin, ymax;      // Mapped to pixel rows 0 and TFT_HEIGHT
+    uint8_t mode;
+    uint8_t n_hoists;
+    GridHoist hoists[GRID_MAX_HOIST];
+} Grid;
+
+// Compiles a function of x and y, replacing the previous one. The grid must
+// not move while compiled, the tree points into it. Returns 0 on success.
+uint8_t grid_compile(Grid *grid, const char *expression);
+void grid_free(Grid *grid);
+// Evaluates the function over the window and draws it in the given mode.
+// Returns 0 on success, 1 when the window is empty or out of memory.
+uint8_t grid_draw(Grid *grid, double xmin, double xmax, double ymin, double ymax, uint8_t mode);
+
+#endif /* GRID_H_ */
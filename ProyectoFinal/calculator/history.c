@@ -0,0 +1,77 @@
+#include "history.h"
+#include <string.h>
+#include <math.h>
+
+static uint8_t hist_slot(const History *hist, uint8_t age) {
+    return (hist->head + HIST_SIZE - 1 - age) % HIST_SIZE;
+}
+
+// Copies expr into the arena for entry e. Starts over at the front when it
+// does not fit before the end, and drops the trees of the other entries it
+// overwrites.
+static void hist_store(History *hist, HistEntry *e, const te_expr *expr) {
+    uint8_t *arena = (uint8_t *) hist->arena;
+    int size = te_size(expr);
+    e->expr = NULL;
+    if (size > (int) sizeof(hist->arena)) return;
+    uint16_t start = hist->arena_end;
+    if (start + size > (int) sizeof(hist->arena)) start = 0;
+    for (uint8_t i = 0; i < HIST_SIZE; i++) {
+        HistEntry *other = &hist->entries[i];
+        if (!other->expr) continue;
+        uint16_t other_start = (uint8_t *) other->expr - arena;
+        if (other_start < start + size && start < other_start + other->expr_size) other->expr = NULL;
+    }
+    e->expr = te_copy(expr, arena + start, size);
+    e->expr_size = size;
+    hist->arena_end = start + size;
+}
+
+te_expr *hist_compile(History *hist, const char *text, int *error) {
+    te_variable vars[] = {{HIST_ANS_NAME, &hist->ans}};
+    return te_compile(text, vars, 1, error);
+}
+
+void hist_push(History *hist, const char *text, const te_expr *expr, double result, double result_im) {
+    hist->ans = result_im == 0 ? result : NAN;
+    if (strlen(text) > HIST_TEXT_LEN) return;
+    HistEntry *e = &hist->entries[hist->head];
+    if (hist->count < HIST_SIZE) hist->count++;
+    e->result = result;
+    e->result_im = result_im;
+    strcpy(e->text, text);
+    hist_store(hist, e, expr);
+    hist->head = (hist->head + 1) % HIST_SIZE;
+}
+
+const HistEntry *hist_get(const History *hist, uint8_t age) {
+    if (age >= hist->count) return NULL;
+    return &hist->entries[hist_slot(hist, age)];
+}
+
+double hist_repeat(History *hist, uint8_t age) {
+    HistEntry e = hist->entries[hist_slot(hist, age)];
+    // Newer entries move back one place to make room at the front, their
+    // trees stay where they are in the arena
+    for (; age > 0; age--) {
+        hist->entries[hist_slot(hist, age)] = hist->entries[hist_slot(hist, age - 1)];
+    }
+    HistEntry *front = &hist->entries[hist_slot(hist, 0)];
+    *front = e;
+    front->result = NAN;
+    front->result_im = 0;
+    if (front->expr) {
+        front->result = te_eval_complex(front->expr, &front->result_im);
+    } else {
+        // Overwritten by newer trees, compile the text and keep the tree again
+        int error = 0;
+        te_expr *expr = hist_compile(hist, front->text, &error);
+        if (expr) {
+            front->result = te_eval_complex(expr, &front->result_im);
+            hist_store(hist, front, expr);
+            te_free(expr);
+        }
+    }
+    hist->ans = front->result_im == 0 ? front->result : NAN;
+    return front->result;
+}
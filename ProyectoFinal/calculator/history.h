@@ -0,0 +1,59 @@
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+#include "../tinyexpr/tinyexpr.h"
+
+// Calc mode history: the last HIST_SIZE expressions with their results and
+// compiled trees. The trees are copied into a fixed arena inside the history,
+// so a repeat evaluates them in place without tokenizing the text again and
+// no heap block outlives a calculation. The arena is filled round robin, a
+// new tree overwrites the oldest ones in its way, and entries that lost their
+// tree compile their text again on a repeat.
+#define HIST_SIZE 4
+// Arena size in te_expr nodes, a leaf takes one and a binary operator a bit more
+#define HIST_ARENA_NODES 16
+// Longest expression kept, longer ones only update the answer
+#define HIST_TEXT_LEN 31
+// Characters of the text shown on the LCD line, minus the "=" column
+#define HIST_SHOWN_LEN 15
+// Name "ans" is bound to in every history expression
+#define HIST_ANS_NAME "ans"
+
+typedef struct hist_entry {
+    double result;
+    double result_im;       // Imaginary part, 0 for real results
+    te_expr *expr;          // Tree in the arena, NULL once overwritten
+    uint16_t expr_size;     // Arena bytes the tree takes
+    char text[HIST_TEXT_LEN + 1];
+} HistEntry;
+
+typedef struct history {
+    HistEntry entries[HIST_SIZE];
+    uint8_t head;           // Slot the next entry goes to
+    uint8_t count;
+    double ans;             // Result of the newest entry, bound to "ans", NaN if complex
+    uint16_t arena_end;     // Offset the next tree goes to
+    te_expr arena[HIST_ARENA_NODES];
+} History;
+
+// Compiles text with "ans" bound to the history's last answer. Same error
+// reporting as te_compile.
+te_expr *hist_compile(History *hist, const char *text, int *error);
+
+// Stores text, a copy of expr and its complex result as the newest entry,
+// replacing the oldest when full, and makes result the new answer. expr stays
+// with the caller. Text longer than HIST_TEXT_LEN is not stored.
+void hist_push(History *hist, const char *text, const te_expr *expr, double result, double result_im);
+
+// Entry age steps back from the newest (age 0), NULL past the oldest.
+const HistEntry *hist_get(const History *hist, uint8_t age);
+
+// Evaluates entry age again with the current answer, e.g. "ans*2" doubles it
+// on every repeat, and moves it to the newest slot. age must name an
+// existing entry. Symbols are read as they were bound when the entry was
+// compiled, like user function bodies do. Returns the real part of the new
+// result, NaN when the tree was overwritten and the text no longer compiles.
+double hist_repeat(History *hist, uint8_t age);
+
+#endif /* HISTORY_H_ */
@@ -0,0 +1,192 @@
+#include "plot_export.h"
+#include <string.h>
+#include <stdlib.h>
+#include "calculator.h"
+
+#ifdef __AVR__
+#include "../usart/usart.h"
+// Blocks while the TX ring is full, a plot is far longer than the ring
+#define EXPORT_TX USART_Transmit_char
+#else
+#include <stdio.h>
+static void export_putchar(uint8_t data) {
+    putchar(data);
+}
+#define EXPORT_TX export_putchar
+#endif
+
+// (x, y) float pairs per PROTO_PLOT_SAMPLES frame after the 2 byte header
+#define SAMPLES_PER_FRAME ((PROTO_MAX_PAYLOAD - 2) / (2 * sizeof(float)))
+// (count, color) runs per PROTO_PLOT_ROW frame after the 2 byte header
+#define RUNS_PER_FRAME ((PROTO_MAX_PAYLOAD - 2) / 3)
+
+static ProtoFrame frame;
+static uint8_t pending = 0;
+
+static void put_float(uint8_t * dest, double value) {
+    float f = value;
+    memcpy(dest, &f, sizeof(float));
+}
+
+static void flush_samples(void) {
+    if (!pending) return;
+    frame.type = PROTO_PLOT_SAMPLES;
+    frame.len = 2 + pending * 2 * sizeof(float);
+    proto_send(&frame, EXPORT_TX);
+    pending = 0;
+}
+
+void plot_export_begin(double xmin, double xmax, double ymin, double ymax) {
+    pending = 0;
+    frame.type = PROTO_PLOT_BEGIN;
+    frame.len = 4 * sizeof(float);
+    put_float(frame.payload, xmin);
+    put_float(frame.payload + 4, xmax);
+    put_float(frame.payload + 8, ymin);
+    put_float(frame.payload + 12, ymax);
+    proto_send(&frame, EXPORT_TX);
+}
+
+void plot_export_sample(uint8_t func, uint8_t index, double x, double y) {
+    if (!(proto_export_flags & PROTO_EXPORT_SAMPLES)) return;
+    // Batches hold consecutive samples of one function
+    if (pending && (frame.payload[0] != func || frame.payload[1] + pending != index)) {
+        flush_samples();
+    }
+    if (!pending) {
+        frame.payload[0] = func;
+        frame.payload[1] = index;
+    }
+    uint8_t *pair = frame.payload + 2 + pending * 2 * sizeof(float);
+    put_float(pair, x);
+    put_float(pair + sizeof(float), y);
+    if (++pending == SAMPLES_PER_FRAME) flush_samples();
+}
+
+// Rows covered in one column by the line drawLine draws towards its neighbour.
+// Mirrors Bresenham: a steep segment puts its first half (counted from the
+// smaller row) in the start column and the rest in the other one.
+static void segment_span(int16_t own, int16_t other, int16_t * lo, int16_t * hi) {
+    int16_t d = own > other ? own - other : other - own;
+    if (d <= 1) return;
+    int16_t first = d / 2 + 1;
+    if (own < other) {
+        if (own + first - 1 > *hi) *hi = own + first - 1;
+    } else {
+        if (other + first < *lo) *lo = other + first;
+    }
+}
+
+// Overlay samples for send_rows, TFT_WIDTH per overlay. The plot keeps none,
+// so they are evaluated once up front instead of for every pixel row. NULL
+// when the heap has no room, then they are evaluated as they are needed.
+static uint8_t *overlay_rows = NULL;
+
+static uint8_t export_sample(Plot * plot, uint8_t f, uint8_t i) {
+    if (f && overlay_rows) return overlay_rows[(f - 1) * TFT_WIDTH + i];
+    return plot_sample(plot, f, i);
+}
+
+// Samples j + 1, j and j - 1 of every function around screen column col,
+// PLOT_Y_NAN past the edges, one per function when moving a column right.
+typedef struct column {
+    uint8_t col;                    // TFT_WIDTH before the first column
+    uint8_t y[PLOT_MAX_FUNCS][3];
+} Column;
+
+static void column_at(Plot * plot, Column * c, uint8_t col) {
+    if (col == c->col) return;
+    bool next = col == c->col + 1;
+    uint8_t j = PLOT_COL(col);
+    c->col = col;
+    for (uint8_t f = 0; f < plot->n_funcs; f++) {
+        uint8_t *y = c->y[f];
+        if (next) {
+            y[0] = y[1];
+            y[1] = y[2];
+        } else {
+            y[0] = j < TFT_WIDTH - 1 ? export_sample(plot, f, j + 1) : PLOT_Y_NAN;
+            y[1] = export_sample(plot, f, j);
+        }
+        y[2] = j > 0 ? export_sample(plot, f, j - 1) : PLOT_Y_NAN;
+    }
+}
+
+// Color of a pixel as the rendering layer leaves it: background, axes, then
+// each function on top of the previous ones.
+static uint16_t pixel_color(Plot * plot, Column * c, int16_t axis_col, int16_t axis_row, uint8_t col, uint8_t row) {
+    column_at(plot, c, col);
+    for (uint8_t f = plot->n_funcs; f-- > 0;) {
+        const uint8_t *y = c->y[f];
+        int16_t own = plot_row(y[1]);
+        int16_t lo = own, hi = own;
+#ifdef DRAW_POINTS
+        if (y[1] == PLOT_Y_NAN) continue;
+#else
+        // Only segments put pixels on screen in line mode
+        bool drawn = false;
+        if (plot_segment_visible(y[1], y[2])) {
+            segment_span(own, plot_row(y[2]), &lo, &hi);
+            drawn = true;
+        }
+        if (plot_segment_visible(y[1], y[0])) {
+            segment_span(own, plot_row(y[0]), &lo, &hi);
+            drawn = true;
+        }
+        if (!drawn) continue;
+#endif
+        if (row >= lo && row <= hi) return plot_colors[f];
+    }
+    if (col == axis_col || row == axis_row) return ST7735_WHITE;
+    return ST7735_BACKGROUND;
+}
+
+static void send_rows(Plot * plot) {
+    Column column;
+    column.col = TFT_WIDTH;
+    int16_t axis_col = plot_axis_col(plot);
+    int16_t axis_row = plot_axis_row(plot);
+    if (plot->n_funcs > 1) overlay_rows = malloc((plot->n_funcs - 1) * TFT_WIDTH);
+    if (overlay_rows) {
+        for (uint8_t f = 1; f < plot->n_funcs; f++) {
+            for (uint8_t i = 0; i < TFT_WIDTH; i++) {
+                overlay_rows[(f - 1) * TFT_WIDTH + i] = plot_sample(plot, f, i);
+            }
+        }
+    }
+    frame.type = PROTO_PLOT_ROW;
+    for (uint8_t row = 0; row < TFT_HEIGHT; row++) {
+        uint8_t col = 0;
+        while (col < TFT_WIDTH) {
+            // One frame per row unless the row needs more runs than fit
+            frame.payload[0] = row;
+            frame.payload[1] = col;
+            uint8_t runs = 0;
+            while (col < TFT_WIDTH && runs < RUNS_PER_FRAME) {
+                uint16_t run_color = pixel_color(plot, &column, axis_col, axis_row, col, row);
+                uint8_t count = 0;
+                while (col < TFT_WIDTH && pixel_color(plot, &column, axis_col, axis_row, col, row) == run_color) {
+                    col++;
+                    count++;
+                }
+                uint8_t *run = frame.payload + 2 + runs * 3;
+                run[0] = count;
+                run[1] = run_color & 0xFF;
+                run[2] = run_color >> 8;
+                runs++;
+            }
+            frame.len = 2 + runs * 3;
+            proto_send(&frame, EXPORT_TX);
+        }
+    }
+    free(overlay_rows);
+    overlay_rows = NULL;
+}
+
+void plot_export_finish(struct plot * plot) {
+    flush_samples();
+    if (proto_export_flags & PROTO_EXPORT_ROWS) send_rows(plot);
+    frame.type = PROTO_PLOT_END;
+    frame.len = 0;
+    proto_send(&frame, EXPORT_TX);
+}
@@ -0,0 +1,28 @@
+#ifndef PLOT_EXPORT_H_
+#define PLOT_EXPORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../usart/protocol.h"
+
+// Streams the plot being drawn as protocol frames so a host can rebuild it
+// without looking at the TFT. Enabled remotely with PROTO_EXPORT:
+//   PROTO_PLOT_BEGIN    plot window
+//   PROTO_PLOT_SAMPLES  raw (x, y) samples, if PROTO_EXPORT_SAMPLES is set
+//   PROTO_PLOT_ROW      RLE RGB565 screen rows, if PROTO_EXPORT_ROWS is set
+//   PROTO_PLOT_END
+
+#define plot_export_enabled() (proto_export_flags != 0)
+
+// Sends the plot window. Call once per plot before any sample.
+void plot_export_begin(double xmin, double xmax, double ymin, double ymax);
+
+// Queues one evaluated sample, flushed in batches.
+void plot_export_sample(uint8_t func, uint8_t index, double x, double y);
+
+struct plot;
+
+// Flushes pending samples, sends the rendered rows if requested and closes the plot.
+void plot_export_finish(struct plot * plot);
+
+#endif /* PLOT_EXPORT_H_ */
@@ -0,0 +1,210 @@
+#include "solver.h"
+#include <math.h>
+#include <float.h>
+
+// Evaluates f at x, charging it to the budget
+static double solver_eval(const te_expr *f, double *var, double x, SolverStats *stats) {
+    *var = x;
+    stats->evals++;
+    return te_eval(f);
+}
+
+static bool solver_out_of_budget(SolverStats *stats) {
+    if (stats->evals < stats->max_evals) return false;
+    stats->exhausted = true;
+    return true;
+}
+
+double solver_newton(const te_expr *f, const te_expr *df, double *var, double lo, double hi, double tol, SolverStats *stats) {
+    // Samples often land exactly on a zero, e.g. x = 0
+    if (solver_eval(f, var, hi, stats) == 0) return hi;
+    double f_lo = solver_eval(f, var, lo, stats);
+    if (f_lo == 0) return lo;
+    // Orient the bracket so that f(lo) < 0 < f(hi)
+    if (f_lo > 0) {
+        double t = lo;
+        lo = hi;
+        hi = t;
+    }
+    double x = (lo + hi) / 2;
+    double last_step = 2 * fabs(hi - lo);
+    for (uint8_t i = 0; i < SOLVER_NEWTON_ITERS && !solver_out_of_budget(stats); i++) {
+        double y = solver_eval(f, var, x, stats);
+        if (y != y) return NAN;
+        if (y == 0) return x;
+        if (y < 0) lo = x; else hi = x;
+        // Derivative evaluations count against the budget too
+        stats->evals++;
+        double slope = te_eval(df);
+        double next = x - y / slope;
+        // Bisect when Newton would leave the bracket or is not halving the step
+        if (!((next - lo) * (next - hi) <= 0) || fabs(y / slope) * 2 > last_step) {
+            next = (lo + hi) / 2;
+        }
+        last_step = fabs(next - x);
+        x = next;
+        if (last_step < tol) return x;
+    }
+    return NAN;
+}
+
+double solver_brent(const te_expr *f, double *var, double a, double b, double tol, SolverStats *stats) {
+    double fa = solver_eval(f, var, a, stats);
+    double fb = solver_eval(f, var, b, stats);
+    if (fa == 0) return a;
+    if (fb == 0) return b;
+    if ((fa > 0) == (fb > 0) || fa != fa || fb != fb) return NAN;
+    // b is the best guess, a the previous one and [b, c] keeps the bracket
+    double c = b, fc = fb;
+    double d = b - a, e = d;
+    while (!solver_out_of_budget(stats)) {
+        if ((fb > 0) == (fc > 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+        double tol1 = 2 * DBL_EPSILON * fabs(b) + tol / 2;
+        double xm = (c - b) / 2;
+        if (fabs(xm) <= tol1 || fb == 0) return b;
+        if (fabs(e) >= tol1 && fabs(fa) > fabs(fb)) {
+            // Secant when only two points are known, inverse quadratic otherwise
+            double p, q, r, s = fb / fa;
+            if (a == c) {
+                p = 2 * xm * s;
+                q = 1 - s;
+            } else {
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2 * xm * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) q = -q; else p = -p;
+            double min1 = 3 * xm * q - fabs(tol1 * q);
+            double min2 = fabs(e * q);
+            // Accept the interpolation only if it stays well inside the bracket
+            if (2 * p < (min1 < min2 ? min1 : min2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = e = xm;
+            }
+        } else {
+            d = e = xm;
+        }
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol1 ? d : (xm > 0 ? tol1 : -tol1);
+        fb = solver_eval(f, var, b, stats);
+        if (fb != fb) return NAN;
+    }
+    return NAN;
+}
+
+// Interval waiting to be integrated, f known at both ends and the middle
+typedef struct simpson_interval {
+    double a, b;
+    double fa, fm, fb;
+    uint8_t depth;
+} SimpsonInterval;
+
+double solver_integrate(const te_expr *f, double *var, double a, double b, double tol, SolverStats *stats) {
+    // Only right halves wait here, at most one per depth level
+    SimpsonInterval pending[SOLVER_SIMPSON_DEPTH];
+    uint8_t n_pending = 0;
+    SimpsonInterval cur = {a, b, 0, 0, 0, 0};
+    cur.fa = solver_eval(f, var, a, stats);
+    cur.fm = solver_eval(f, var, (a + b) / 2, stats);
+    cur.fb = solver_eval(f, var, b, stats);
+    double total = 0;
+    stats->error = 0;
+    while (true) {
+        double m = (cur.a + cur.b) / 2;
+        double h = (cur.b - cur.a) / 12;
+        double flm = solver_eval(f, var, (cur.a + m) / 2, stats);
+        double frm = solver_eval(f, var, (m + cur.b) / 2, stats);
+        double whole = 2 * h * (cur.fa + 4 * cur.fm + cur.fb);
+        double left = h * (cur.fa + 4 * flm + cur.fm);
+        double right = h * (cur.fm + 4 * frm + cur.fb);
+        double delta = left + right - whole;
+        if (delta != delta) {
+            stats->error = NAN;
+            return NAN;
+        }
+        // Each level halves the tolerance, the halves share it
+        double eps = ldexp(tol, -cur.depth);
+        bool at_limit = cur.depth == SOLVER_SIMPSON_DEPTH || solver_out_of_budget(stats);
+        bool converged = fabs(delta) <= 15 * eps && cur.depth >= SOLVER_SIMPSON_MIN_DEPTH;
+        if (converged || at_limit) {
+            if (!converged) stats->exhausted = true;
+            // Richardson extrapolation of the two Simpson estimates
+            total += left + right + delta / 15;
+            stats->error += fabs(delta) / 15;
+            if (!n_pending) break;
+            cur = pending[--n_pending];
+        } else {
+            SimpsonInterval right_half = {m, cur.b, cur.fm, frm, cur.fb, cur.depth + 1};
+            pending[n_pending++] = right_half;
+            cur.b = m;
+            cur.fb = cur.fm;
+            cur.fm = flm;
+            cur.depth++;
+        }
+    }
+    return total;
+}
+
+// Sign of sample i of plot function func, 0 when undefined. The cached pixel
+// row of the first function settles most samples, only the row holding y = 0
+// and samples clipped on the far side of the axis are evaluated again.
+// Overlays have no cached rows and are always evaluated.
+static int8_t sample_sign(Plot *plot, uint8_t func, uint8_t i, SolverStats *stats) {
+    if (!func) {
+        uint8_t y = plot->y_vals[i];
+        double row_height = (plot->ymax - plot->ymin) / TFT_HEIGHT;
+        if (y == PLOT_Y_NAN) return 0;
+        if (y == PLOT_Y_BELOW && plot->ymin <= 0) return -1;
+        if (y == PLOT_Y_ABOVE && plot->ymax >= 0) return 1;
+        if (y < TFT_HEIGHT) {
+            double bottom = plot->ymin + y * row_height;
+            if (bottom >= 0) return 1;
+            if (bottom + row_height < 0) return -1;
+        }
+    }
+    double real_y = solver_eval(plot->exprs[func], &plot->real_x, plot_x(plot, i), stats);
+    if (real_y != real_y) return 0;
+    return real_y < 0 ? -1 : 1;
+}
+
+uint8_t solver_plot_zeros(Plot *plot, uint8_t func, const te_expr *df, double *zeros, uint8_t max_zeros, SolverStats *stats) {
+    const te_expr *f = plot->exprs[func];
+    double dx = (plot->xmax - plot->xmin) / TFT_WIDTH;
+    // A zero must be resolved to well below a column, and f there must be
+    // within a pixel of 0 or the sign change was a pole or a jump
+    double tol = dx / 1024;
+    double max_residual = (plot->ymax - plot->ymin) / TFT_HEIGHT;
+    uint8_t n = 0;
+    int8_t last = sample_sign(plot, func, 0, stats);
+    for (uint8_t i = 1; i < TFT_WIDTH && n < max_zeros && !solver_out_of_budget(stats); i++) {
+        int8_t sign = sample_sign(plot, func, i, stats);
+        if (sign && last && sign != last) {
+            // Brackets use the plot's own sample x, so zeros on a sample are hit exactly
+            double lo = plot_x(plot, i - 1), hi = plot_x(plot, i);
+            double x = df ? solver_newton(f, df, &plot->real_x, lo, hi, tol, stats)
+                          : solver_brent(f, &plot->real_x, lo, hi, tol, stats);
+            if (x == x && fabs(solver_eval(f, &plot->real_x, x, stats)) <= max_residual) {
+                zeros[n++] = x;
+            }
+        }
+        last = sign;
+    }
+    return n;
+}
+
+double solver_plot_integral(Plot *plot, uint8_t func, SolverStats *stats) {
+    double tol = (plot->xmax - plot->xmin) * (plot->ymax - plot->ymin) / ((double) TFT_WIDTH * TFT_HEIGHT) / 16;
+    return solver_integrate(plot->exprs[func], &plot->real_x, plot->xmin, plot->xmax, tol, stats);
+}
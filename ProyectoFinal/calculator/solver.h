@@ -0,0 +1,58 @@
+#ifndef SOLVER_H_
+#define SOLVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../tinyexpr/tinyexpr.h"
+#include "calculator.h"
+
+// Most zeros reported per function
+#define SOLVER_MAX_ZEROS 8
+// Newton iterations allowed per bracket
+#define SOLVER_NEWTON_ITERS 20
+// Default evaluation budgets
+#define SOLVER_ROOT_EVALS 200
+#define SOLVER_INTEGRAL_EVALS 400
+// Deepest interval split of the adaptive Simpson rule, each level keeps one
+// pending interval of 5 doubles on the stack
+#define SOLVER_SIMPSON_DEPTH 10
+// Intervals are always split this deep, so a lucky agreement of the coarse
+// estimates on a kink or a periodic function is not taken as converged
+#define SOLVER_SIMPSON_MIN_DEPTH 3
+
+// Evaluation budget and bookkeeping shared by all solvers. Set max_evals and
+// clear the rest before a run, evals keeps counting across calls so one
+// budget can cover a whole plot.
+typedef struct solver_stats {
+    uint16_t max_evals;     // Budget, the solver stops when evals reaches it
+    uint16_t evals;         // Function evaluations used so far
+    double error;           // Error estimate of the last integral
+    bool exhausted;         // A result was cut short by the budget or depth limit
+} SolverStats;
+
+// Newton-Raphson for a zero of f inside [lo, hi], where f changes sign. df is
+// the derivative of f and both are bound to var. Steps that leave the bracket
+// or stall fall back to bisection, so the search always converges. Returns NAN
+// when the bracket holds no zero (e.g. a pole) or the iterations run out.
+double solver_newton(const te_expr *f, const te_expr *df, double *var, double lo, double hi, double tol, SolverStats *stats);
+
+// Brent's method for a zero of f inside [a, b], where f changes sign. Needs
+// no derivative and converges superlinearly on smooth functions while never
+// doing worse than bisection. Returns NAN without a sign change or budget.
+double solver_brent(const te_expr *f, double *var, double a, double b, double tol, SolverStats *stats);
+
+// Integral of f over [a, b] with the adaptive Simpson rule, splitting only
+// where the estimate is off by more than tol. stats->error gets the error
+// estimate. Returns NAN if f is undefined at a sample.
+double solver_integrate(const te_expr *f, double *var, double a, double b, double tol, SolverStats *stats);
+
+// Zeros of plot function func, bracketed by sign changes in its cached samples
+// and refined with solver_newton, or solver_brent when df is NULL. Returns
+// how many were stored in zeros.
+uint8_t solver_plot_zeros(Plot *plot, uint8_t func, const te_expr *df, double *zeros, uint8_t max_zeros, SolverStats *stats);
+
+// Integral of plot function func over the plot window, to a small fraction
+// of a pixel's area.
+double solver_plot_integral(Plot *plot, uint8_t func, SolverStats *stats);
+
+#endif /* SOLVER_H_ */
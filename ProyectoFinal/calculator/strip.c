@@ -0,0 +1,150 @@
+#include "strip.h"
+#include "calculator.h"
+#include "../SPI/spilib.h"
+#include "../tick/tick.h"
+#include <math.h>
+
+// Pixel row of a value, or one of the PLOT_Y_* markers when it does not land
+// inside the window, as the samples of a plot
+static uint8_t strip_row(const Strip *strip, double value) {
+    double row = (value - strip->ymin) * TFT_HEIGHT / (strip->ymax - strip->ymin);
+    if (row != row) return PLOT_Y_NAN;
+    if (row < 0) return PLOT_Y_BELOW;
+    if (row >= TFT_HEIGHT) return PLOT_Y_ABOVE;
+    return (uint8_t) row;
+}
+
+static int16_t strip_axis_row(const Strip *strip) {
+    if (strip->ymin > 0 || strip->ymax < 0) return -1;
+    int16_t row = (int16_t) (-strip->ymin * TFT_HEIGHT / (strip->ymax - strip->ymin));
+    return row < TFT_HEIGHT ? row : -1;
+}
+
+// Values of the traces of the curve at t
+static void strip_eval(Curve *curve, double t, double *values) {
+    curve->real_t = t;
+    PROF_BEGIN(PROF_TE_EVAL);
+    values[0] = te_eval(curve->fx);
+    if (curve->fy) values[1] = te_eval(curve->fy);
+    PROF_END(PROF_TE_EVAL);
+}
+
+// Writes screen column 0 in a single window, top to bottom in runs of one
+// color: the background, the axis with a time mark every
+// STRIP_MARK_SAMPLES, and trace f over rows [lo[f], hi[f]], later traces on
+// top
+static void strip_column(const Strip *strip, const int16_t *lo, const int16_t *hi) {
+    int16_t axis_lo = strip_axis_row(strip), axis_hi = axis_lo;
+    if (axis_lo >= 0 && !strip->mark) {
+        axis_lo -= PLOT_TICK_LEN;
+        axis_hi += PLOT_TICK_LEN;
+    }
+    // Screen column 0 is RAM column scroll offset
+    uint8_t x = getScrollOffset();
+    setAddrWindow(x, 0, x, TFT_HEIGHT - 1);
+    uint16_t run_color = ST7735_BACKGROUND;
+    uint8_t run = 0;
+    for (int16_t row = 0; row < TFT_HEIGHT; row++) {
+        uint16_t color = ST7735_BACKGROUND;
+        if (row >= axis_lo && row <= axis_hi) color = ST7735_WHITE;
+        for (uint8_t f = 0; f < strip->n_traces; f++) {
+            if (row >= lo[f] && row <= hi[f]) color = plot_colors[f];
+        }
+        if (color != run_color) {
+            wr(run_color, run);
+            run_color = color;
+            run = 0;
+        }
+        run++;
+    }
+    wr(run_color, run);
+}
+
+uint8_t strip_begin(Strip *strip, uint8_t n_traces, double ymin, double ymax) {
+    if (!n_traces || n_traces > STRIP_MAX_TRACES || !(ymin < ymax)) return 1;
+    strip->curve = NULL;
+    strip->running = false;
+    strip->n_traces = n_traces;
+    strip->ymin = ymin;
+    strip->ymax = ymax;
+    for (uint8_t f = 0; f < STRIP_MAX_TRACES; f++) {
+        strip->rows[f] = PLOT_Y_NAN;
+    }
+    strip->mark = 0;
+    strip->last = tick_now();
+    fillScreen(ST7735_BACKGROUND);
+    int16_t axis_row = strip_axis_row(strip);
+    if (axis_row >= 0) drawFastHLine(0, axis_row, TFT_WIDTH, ST7735_WHITE);
+    return 0;
+}
+
+uint8_t strip_begin_curve(Strip *strip, Curve *curve, double tmin, double tmax) {
+    double lo = INFINITY, hi = -INFINITY;
+    double values[STRIP_MAX_TRACES];
+    if (!curve->fx || !(tmin < tmax)) return 1;
+    uint8_t n_traces = curve->fy ? 2 : 1;
+    for (uint8_t s = 0; s <= STRIP_SCALE_SAMPLES; s++) {
+        strip_eval(curve, tmin + (tmax - tmin) * s / STRIP_SCALE_SAMPLES, values);
+        for (uint8_t f = 0; f < n_traces; f++) {
+            if (!isfinite(values[f])) continue;
+            if (values[f] < lo) lo = values[f];
+            if (values[f] > hi) hi = values[f];
+        }
+    }
+    if (!(lo <= hi)) return 1;
+    // Constant traces still get a usable window
+    double margin = (hi - lo) * STRIP_MARGIN;
+    if (!(margin > 0)) margin = 1;
+    strip_begin(strip, n_traces, lo - margin, hi + margin);
+    strip->curve = curve;
+    strip->t = tmin;
+    strip->dt = (tmax - tmin) / TFT_WIDTH;
+    strip->running = true;
+    return 0;
+}
+
+void strip_push(Strip *strip, const double *values) {
+    int16_t lo[STRIP_MAX_TRACES], hi[STRIP_MAX_TRACES];
+    for (uint8_t f = 0; f < strip->n_traces; f++) {
+        uint8_t prev = strip->rows[f];
+        uint8_t row = strip_row(strip, values[f]);
+        strip->rows[f] = row;
+        // The step from the previous sample is drawn in the new column, or
+        // the point alone after a gap
+        if (row == PLOT_Y_NAN || !plot_segment_visible(prev, row)) {
+            lo[f] = hi[f] = row < TFT_HEIGHT ? row : -1;
+            continue;
+        }
+        lo[f] = plot_row(prev);
+        hi[f] = plot_row(row);
+        if (lo[f] > hi[f]) {
+            int16_t swap = lo[f];
+            lo[f] = hi[f];
+            hi[f] = swap;
+        }
+    }
+    // The picture moves left by a column, what was the leftmost one comes
+    // back on the right
+    setScrollOffset((getScrollOffset() + TFT_WIDTH - 1) % TFT_WIDTH);
+    strip_column(strip, lo, hi);
+    if (++strip->mark == STRIP_MARK_SAMPLES) strip->mark = 0;
+}
+
+bool strip_poll(Strip *strip) {
+    double values[STRIP_MAX_TRACES];
+    if (!strip->running) return false;
+    uint16_t late = tick_now() - strip->last;
+    if (late < STRIP_PERIOD_MS) return false;
+    // Samples keep their period, unless the chart fell a whole period behind
+    strip->last += late < 2 * STRIP_PERIOD_MS ? STRIP_PERIOD_MS : late;
+    strip_eval(strip->curve, strip->t, values);
+    strip->t += strip->dt;
+    strip_push(strip, values);
+    return true;
+}
+
+void strip_stop(Strip *strip) {
+    strip->running = false;
+    strip->curve = NULL;
+    strip->n_traces = 0;
+}
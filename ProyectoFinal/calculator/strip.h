@@ -0,0 +1,49 @@
+#ifndef STRIP_H_
+#define STRIP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "curve.h"
+
+// Strip chart: a live value drawn one sample at a time. Every sample enters
+// at the right edge while the picture moves left with the hardware scroll,
+// so it costs one scroll start line command and one column window, instead
+// of a full replot. Samples come from the functions of t of a curve, taken
+// on the tick, or are pushed from outside, e.g. over USART.
+#define STRIP_MAX_TRACES 2
+// Milliseconds between samples of a curve
+#define STRIP_PERIOD_MS 40
+// Samples between time marks on the axis
+#define STRIP_MARK_SAMPLES 32
+// Samples of the pass that fits the window, over the first screen of t
+#define STRIP_SCALE_SAMPLES 64
+// Fraction of the window left above and below the fitted values
+#define STRIP_MARGIN 0.1
+
+typedef struct strip {
+    Curve *curve;           // Source of the samples, NULL while they are pushed
+    uint8_t n_traces;       // 0 while no strip chart is on screen
+    bool running;           // The curve is sampled on the tick
+    double t, dt;           // Next t of the curve and its step per sample
+    double ymin, ymax;      // Mapped to pixel rows 0 and TFT_HEIGHT
+    uint8_t rows[STRIP_MAX_TRACES];     // Pixel row of the previous sample or a PLOT_Y_* marker
+    uint8_t mark;           // Samples since the last time mark
+    uint16_t last;          // Tick of the last sample
+} Strip;
+
+// Clears the screen for n_traces values per sample over [ymin, ymax].
+// Returns 1 when the window is empty.
+uint8_t strip_begin(Strip *strip, uint8_t n_traces, double ymin, double ymax);
+// Charts a compiled curve against time: r(t), or x(t) and y(t). A screen
+// spans [tmin, tmax] of t, starting at tmin, and the window is fit to that
+// span. Returns 1 when the curve is undefined there or the span is empty.
+uint8_t strip_begin_curve(Strip *strip, Curve *curve, double tmin, double tmax);
+// Scrolls by one column and draws the next sample, one value per trace
+void strip_push(Strip *strip, const double *values);
+// Takes the next sample of the curve once STRIP_PERIOD_MS passed. Returns
+// true when it drew one.
+bool strip_poll(Strip *strip);
+// Leaves the picture as it is, the curve is no longer used
+void strip_stop(Strip *strip);
+
+#endif /* STRIP_H_ */
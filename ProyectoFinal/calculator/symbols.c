@@ -0,0 +1,357 @@
+#include "symbols.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+#define SYM_EEPROM_SIZE (E2END + 1)
+#define ee_read(addr) eeprom_read_byte((const uint8_t *) (uintptr_t) (addr))
+#define ee_write(addr, data) eeprom_update_byte((uint8_t *) (uintptr_t) (addr), (data))
+#else
+// Host builds keep the EEPROM in RAM, stored inverted so the zeroed array
+// reads as erased cells
+#define SYM_EEPROM_SIZE 1024
+static uint8_t ee_mem[SYM_EEPROM_SIZE];
+
+static uint8_t ee_read(uint16_t addr) {
+    return ~ee_mem[addr];
+}
+
+static void ee_write(uint16_t addr, uint8_t data) {
+    ee_mem[addr] = ~data;
+}
+#endif
+
+// Bank layout: a 16-bit generation, then records up to a 0xFF length byte.
+// Record: length, id, payload[length], check. The id is the letter index,
+// with SYM_ID_FUNC set for functions. A variable's payload is its value as a
+// float, a function's is the parameter letter followed by the body text.
+#define SYM_BANK_SIZE (SYM_EEPROM_SIZE / 2)
+#define SYM_BANK_HEADER 2
+#define SYM_RECORD_OVERHEAD 3
+#define SYM_ID_FUNC 0x80
+#define SYM_END 0xFF
+
+enum {SYM_EMPTY, SYM_VAR, SYM_FUNC};
+// Set in kind while a function body compiles, so it cannot call itself
+#define SYM_COMPILING 0x80
+// Bodies read back from EEPROM compiled one inside the other, f calling g
+// calling h. A deeper chain fails until its inner functions were used once.
+#define SYM_MAX_NESTING 3
+
+typedef struct sym_slot {
+    uint8_t letter;         // Letter index, valid unless kind is SYM_EMPTY
+    uint8_t kind;
+    double value;           // Variable value, or the argument during a function call
+    te_expr *body;          // Function body, compiled on first use
+    uint16_t record;        // EEPROM address of the latest record
+} SymSlot;
+
+static SymSlot table[SYM_SLOTS];
+static bool loaded;
+static uint8_t nesting;     // Bodies being compiled lazily
+static uint8_t calls;       // Function calls in progress
+static uint8_t bank;
+static uint16_t generation;
+static uint16_t log_end;    // Address of the end marker in the active bank
+static bool log_damaged;    // A torn record was found, compact before appending
+static te_variable found;
+
+static uint16_t ee_read_word(uint16_t addr) {
+    return ee_read(addr) | (uint16_t) ee_read(addr + 1) << 8;
+}
+
+static void ee_write_word(uint16_t addr, uint16_t data) {
+    ee_write(addr, (uint8_t) data);
+    ee_write(addr + 1, (uint8_t) (data >> 8));
+}
+
+// Slot of a letter index, NULL when it is not defined
+static SymSlot *sym_slot(uint8_t letter) {
+    for (uint8_t i = 0; i < SYM_SLOTS; i++) {
+        // A free slot is only marked while a new letter's body compiles
+        if ((table[i].kind & ~SYM_COMPILING) != SYM_EMPTY && table[i].letter == letter) return &table[i];
+    }
+    return NULL;
+}
+
+// Slot of a letter index, or a free one for it. NULL when all are taken.
+static SymSlot *sym_claim(uint8_t letter) {
+    SymSlot *slot = sym_slot(letter);
+    for (uint8_t i = 0; !slot && i < SYM_SLOTS; i++) {
+        if (table[i].kind == SYM_EMPTY) slot = &table[i];
+    }
+    return slot;
+}
+
+static uint8_t record_check(uint8_t len, uint8_t id, const uint8_t *payload) {
+    uint8_t check = len ^ id ^ 0x5A;
+    for (uint8_t i = 0; i < len; i++) check = (check << 1 | check >> 7) ^ payload[i];
+    return check;
+}
+
+// Reads the active bank into the table, the newest record of a letter wins
+static void sym_scan(void) {
+    uint16_t base = bank * SYM_BANK_SIZE;
+    uint16_t pos = base + SYM_BANK_HEADER;
+    log_damaged = false;
+    while (pos < base + SYM_BANK_SIZE) {
+        uint8_t len = ee_read(pos);
+        if (len == SYM_END) break;
+        uint8_t payload[SYM_TEXT_MAX + 1];
+        uint8_t id = ee_read(pos + 1);
+        uint8_t letter = id & ~SYM_ID_FUNC;
+        if (len > sizeof(payload) || pos + len + SYM_RECORD_OVERHEAD > base + SYM_BANK_SIZE
+                || letter >= SYM_COUNT) {
+            log_damaged = true;
+            break;
+        }
+        for (uint8_t i = 0; i < len; i++) payload[i] = ee_read(pos + 2 + i);
+        if (ee_read(pos + 2 + len) != record_check(len, id, payload)) {
+            log_damaged = true;
+            break;
+        }
+        SymSlot *slot = sym_claim(letter);
+        pos += len + SYM_RECORD_OVERHEAD;
+        // Only a log written with more slots holds more letters
+        if (!slot) continue;
+        te_free(slot->body);
+        slot->letter = letter;
+        slot->body = NULL;
+        slot->record = pos - len - SYM_RECORD_OVERHEAD;
+        if (id & SYM_ID_FUNC) {
+            slot->kind = SYM_FUNC;
+        } else {
+            float value;
+            memcpy(&value, payload, sizeof(float));
+            slot->kind = SYM_VAR;
+            slot->value = value;
+        }
+    }
+    log_end = pos;
+}
+
+// Reads the table back on first use
+static void sym_load(void) {
+    if (loaded) return;
+    loaded = true;
+    uint16_t gen0 = ee_read_word(0);
+    uint16_t gen1 = ee_read_word(SYM_BANK_SIZE);
+    if (gen0 == 0xFFFF && gen1 == 0xFFFF) {
+        // Blank EEPROM, start an empty log in bank 0
+        bank = 0;
+        generation = 0;
+        ee_write(SYM_BANK_HEADER, SYM_END);
+        ee_write_word(0, generation);
+    } else if (gen1 == 0xFFFF || (gen0 != 0xFFFF && (uint16_t) (gen1 - gen0) >= 0x8000)) {
+        bank = 0;
+        generation = gen0;
+    } else {
+        bank = 1;
+        generation = gen1;
+    }
+    sym_scan();
+}
+
+// Writes a record at log_end. The length byte, which still reads as the end
+// marker, goes last so a reset halfway leaves the log as it was.
+static bool sym_append(uint8_t id, const uint8_t *payload, uint8_t len) {
+    uint16_t end = bank * SYM_BANK_SIZE + SYM_BANK_SIZE;
+    if (log_damaged || log_end + len + SYM_RECORD_OVERHEAD > end) return false;
+    uint16_t pos = log_end;
+    ee_write(pos + 1, id);
+    for (uint8_t i = 0; i < len; i++) ee_write(pos + 2 + i, payload[i]);
+    ee_write(pos + 2 + len, record_check(len, id, payload));
+    log_end = pos + len + SYM_RECORD_OVERHEAD;
+    if (log_end < end) ee_write(log_end, SYM_END);
+    ee_write(pos, len);
+    return true;
+}
+
+static uint8_t record_length(const SymSlot *slot) {
+    if (slot->kind == SYM_VAR) return sizeof(float) + SYM_RECORD_OVERHEAD;
+    if (slot->kind == SYM_FUNC) return ee_read(slot->record) + SYM_RECORD_OVERHEAD;
+    return 0;
+}
+
+// Rewrites the live definitions but letter skip into the other bank, followed
+// by the new record, and switches to it. The new bank only becomes valid once
+// its generation is written, a reset before that keeps the old one. Returns
+// the address of the new record.
+static uint16_t sym_compact(uint8_t skip, uint8_t id, const uint8_t *payload, uint8_t len) {
+    bank ^= 1;
+    uint16_t base = bank * SYM_BANK_SIZE;
+    ee_write_word(base, 0xFFFF);
+    log_end = base + SYM_BANK_HEADER;
+    ee_write(log_end, SYM_END);
+    log_damaged = false;
+    for (uint8_t i = 0; i < SYM_SLOTS; i++) {
+        SymSlot *slot = &table[i];
+        if (slot->letter == skip) continue;
+        if (slot->kind == SYM_VAR) {
+            float value = slot->value;
+            slot->record = log_end;
+            sym_append(slot->letter, (const uint8_t *) &value, sizeof(float));
+        } else if (slot->kind == SYM_FUNC) {
+            uint8_t copy[SYM_TEXT_MAX + 1];
+            uint8_t copy_len = ee_read(slot->record);
+            for (uint8_t i = 0; i < copy_len; i++) copy[i] = ee_read(slot->record + 2 + i);
+            slot->record = log_end;
+            sym_append(slot->letter | SYM_ID_FUNC, copy, copy_len);
+        }
+    }
+    uint16_t pos = log_end;
+    sym_append(id, payload, len);
+    // 0xFFFF marks an invalid bank
+    if (++generation == 0xFFFF) generation = 0;
+    ee_write_word(base, generation);
+    return pos;
+}
+
+// Appends a record for a letter, compacting if the bank is full. Returns the
+// record address, 0 when the definitions do not fit in a bank.
+static uint16_t sym_persist(uint8_t id, const uint8_t *payload, uint8_t len) {
+    uint8_t letter = id & ~SYM_ID_FUNC;
+    uint16_t pos = log_end;
+    if (sym_append(id, payload, len)) return pos;
+    uint16_t size = SYM_BANK_HEADER + len + SYM_RECORD_OVERHEAD;
+    for (uint8_t i = 0; i < SYM_SLOTS; i++) {
+        if (table[i].letter != letter) size += record_length(&table[i]);
+    }
+    if (size > SYM_BANK_SIZE) return 0;
+    return sym_compact(letter, id, payload, len);
+}
+
+static double sym_call(void *context, double arg) {
+    SymSlot *slot = context;
+    // The letter may have been redefined as a variable since. Redefining a
+    // function can also close a loop, f calling g calling f, while a plain
+    // chain calls each function once at most.
+    if (slot->kind != SYM_FUNC || !slot->body || calls == SYM_SLOTS) return NAN;
+    slot->value = arg;
+    calls++;
+    double result = te_eval(slot->body);
+    calls--;
+    return result;
+}
+
+static te_expr *sym_compile_body(SymSlot *slot, char param, const char *text, int *error) {
+    char name[2] = {param, '\0'};
+    te_variable vars[] = {{name, &slot->value, TE_VARIABLE, 0}};
+    slot->kind |= SYM_COMPILING;
+    te_expr *body = te_compile(text, vars, 1, error);
+    slot->kind &= ~SYM_COMPILING;
+    return body;
+}
+
+// Compiles a function read back from EEPROM
+static bool sym_compile_record(SymSlot *slot) {
+    char text[SYM_TEXT_MAX + 1];
+    uint8_t len = ee_read(slot->record);
+    char param = ee_read(slot->record + 2);
+    for (uint8_t i = 1; i < len; i++) text[i - 1] = ee_read(slot->record + 2 + i);
+    text[len - 1] = '\0';
+    int error;
+    slot->body = sym_compile_body(slot, param, text, &error);
+    return slot->body != NULL;
+}
+
+static const te_variable *sym_resolve(const char *name, int len) {
+    if (len != 1 || name[0] < 'a' || name[0] > 'z') return NULL;
+    sym_load();
+    SymSlot *slot = sym_slot(name[0] - 'a');
+    if (!slot) return NULL;
+    found.context = NULL;
+    if (slot->kind == SYM_VAR) {
+        found.address = &slot->value;
+        found.type = TE_VARIABLE;
+    } else if (slot->kind == SYM_FUNC) {
+        if (!slot->body) {
+            // Each level is a te_compile on the stack
+            if (nesting == SYM_MAX_NESTING) return NULL;
+            nesting++;
+            bool compiled = sym_compile_record(slot);
+            nesting--;
+            if (!compiled) return NULL;
+        }
+        found.address = sym_call;
+        found.type = TE_CLOSURE1;
+        found.context = slot;
+    } else {
+        return NULL;
+    }
+    return &found;
+}
+
+void sym_init(void) {
+    te_set_resolver(sym_resolve);
+}
+
+uint8_t sym_define(const char *text, double *result, int *error) {
+    char letter = text[0];
+    char param = 0;
+    const char *body_text;
+    if (letter < 'a' || letter > 'z') return SYM_NONE;
+    if (text[1] == '=') {
+        body_text = text + 2;
+    } else if (text[1] == '(' && text[2] >= 'a' && text[2] <= 'z' && text[3] == ')' && text[4] == '=') {
+        param = text[2];
+        body_text = text + 5;
+    } else {
+        return SYM_NONE;
+    }
+    *error = 0;
+    *result = NAN;
+    sym_load();
+    uint8_t index = letter - 'a';
+    SymSlot *slot = sym_claim(index);
+    if (!slot) return SYM_ERR_FULL;
+
+    if (!param) {
+        te_expr *expr = te_compile(body_text, 0, 0, error);
+        if (!expr) {
+            *error += body_text - text;
+            return SYM_ERR_EXPR;
+        }
+        float value = te_eval(expr);
+        te_free(expr);
+        uint16_t record = sym_persist(index, (const uint8_t *) &value, sizeof(float));
+        if (!record) return SYM_ERR_FULL;
+        te_free(slot->body);
+        slot->letter = index;
+        slot->body = NULL;
+        slot->kind = SYM_VAR;
+        slot->value = value;
+        slot->record = record;
+        *result = value;
+        return SYM_OK;
+    }
+
+    uint8_t len = strlen(body_text);
+    if (len > SYM_TEXT_MAX - 1) {
+        *error = SYM_TEXT_MAX + (body_text - text);
+        return SYM_ERR_EXPR;
+    }
+    // The old definition stays until the new one is stored
+    te_expr *body = sym_compile_body(slot, param, body_text, error);
+    if (!body) {
+        *error += body_text - text;
+        return SYM_ERR_EXPR;
+    }
+    uint8_t payload[SYM_TEXT_MAX + 1];
+    payload[0] = param;
+    memcpy(payload + 1, body_text, len);
+    uint16_t record = sym_persist(index | SYM_ID_FUNC, payload, len + 1);
+    if (!record) {
+        te_free(body);
+        return SYM_ERR_FULL;
+    }
+    te_free(slot->body);
+    slot->letter = index;
+    slot->body = body;
+    slot->kind = SYM_FUNC;
+    slot->record = record;
+    return SYM_OK;
+}
@@ -0,0 +1,39 @@
+#ifndef SYMBOLS_H_
+#define SYMBOLS_H_
+
+#include <stdint.h>
+#include "../tinyexpr/tinyexpr.h"
+
+// User symbols named by a letter a..z, either a variable ("a=2*pi") or a
+// function of one argument ("f(t)=t^2+a"). Up to SYM_SLOTS letters are defined
+// at once, each in a slot of a static table found by a linear search, and
+// defining a ninth letter fails with SYM_ERR_FULL. Every expression sees them
+// through a tinyexpr resolver, after the caller's own variables (x in a plot)
+// and before the builtins.
+//
+// Definitions are persisted in EEPROM as an append-only log. The EEPROM is
+// split into two banks. Records go to the end of the active bank, and when it
+// is full the live definitions are compacted into the other one, so repeated
+// assignments wear the whole bank instead of a few cells. The table is read
+// back on the first use of a single-letter name after a reset.
+#define SYM_COUNT 26
+// Letters defined at once, each takes a slot of the static table
+#define SYM_SLOTS 8
+// Longest function body, in characters
+#define SYM_TEXT_MAX 32
+
+enum sym_status {
+    SYM_NONE = 0,           // The text is not a definition
+    SYM_OK,
+    SYM_ERR_EXPR,           // Compile error, position in *error
+    SYM_ERR_FULL            // No free slot, or no room left in EEPROM even after compaction
+};
+
+// Installs the resolver. Reads nothing until a symbol is used.
+void sym_init(void);
+
+// Handles "a=expr", storing the value of expr in a, and "f(t)=expr", defining
+// f with parameter t. *result gets the value stored, NAN for a function.
+uint8_t sym_define(const char *text, double *result, int *error);
+
+#endif /* SYMBOLS_H_ */
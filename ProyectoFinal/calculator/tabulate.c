@@ -0,0 +1,99 @@
+#include "tabulate.h"
+#include <stdlib.h>
+#include <math.h>
+
+// Chebyshev nodes of degree TAB_DEGREE on [-1, 1], cos(pi * (k + 0.5) / 4)
+static const double cheb_nodes[TAB_DEGREE + 1] = {0.92387953, 0.38268343, -0.38268343, -0.92387953};
+// Where each fit is checked, between and outside the nodes
+#define TAB_CHECKS 5
+static const double check_points[TAB_CHECKS] = {-1.0, -0.65, 0.0, 0.65, 1.0};
+
+static double tab_eval(void *context, double x) {
+    Tabulation *tab = context;
+    double u = (x - tab->xmin) * tab->scale;
+    // NaN fails the range check too and goes to the tree
+    if (u >= 0 && u < TAB_SEGMENTS) {
+        uint8_t seg = (uint8_t) u;
+        if (!(tab->exact & (1U << seg))) {
+            double t = 2 * (u - seg) - 1;
+            const double *c = tab->coef[seg];
+            return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+        }
+    }
+    *tab->var = x;
+    return te_eval(tab->expr);
+}
+
+// Interpolates segment seg and checks it, returns 0 when within tol
+static uint8_t tab_fit_segment(Tabulation *tab, uint8_t seg, double tol) {
+    double f[TAB_DEGREE + 1];
+    double cheb[TAB_DEGREE + 1] = {0, 0, 0, 0};
+    double width = 1 / tab->scale;
+    double x0 = tab->xmin + seg * width;
+    for (uint8_t k = 0; k <= TAB_DEGREE; k++) {
+        *tab->var = x0 + (cheb_nodes[k] + 1) / 2 * width;
+        f[k] = te_eval(tab->expr);
+        if (f[k] != f[k]) return 1;
+    }
+    // c_j = 2/n * sum f(t_k) T_j(t_k), T_j(t_k) = cos(j * theta_k)
+    for (uint8_t k = 0; k <= TAB_DEGREE; k++) {
+        double t = cheb_nodes[k];
+        double t2 = 2 * t * t - 1;
+        cheb[0] += f[k];
+        cheb[1] += f[k] * t;
+        cheb[2] += f[k] * t2;
+        cheb[3] += f[k] * (2 * t * t2 - t);
+    }
+    for (uint8_t j = 0; j <= TAB_DEGREE; j++) cheb[j] /= 2;
+    cheb[0] /= 2;
+    // To power form: T2 = 2t^2 - 1, T3 = 4t^3 - 3t
+    double *c = tab->coef[seg];
+    c[0] = cheb[0] - cheb[2];
+    c[1] = cheb[1] - 3 * cheb[3];
+    c[2] = 2 * cheb[2];
+    c[3] = 4 * cheb[3];
+    for (uint8_t k = 0; k < TAB_CHECKS; k++) {
+        double t = check_points[k];
+        *tab->var = x0 + (t + 1) / 2 * width;
+        double err = te_eval(tab->expr) - (c[0] + t * (c[1] + t * (c[2] + t * c[3])));
+        if (!(fabs(err) <= tol)) return 1;
+    }
+    return 0;
+}
+
+te_expr *tab_compile(te_expr *expr, double *var, double xmin, double xmax, double tol, Tabulation **tab) {
+    // Allocated only while tabulation is on, it is larger than the whole tree
+    Tabulation *t = malloc(sizeof(Tabulation));
+    if (t == NULL) return NULL;
+    t->expr = expr;
+    t->var = var;
+    t->xmin = xmin;
+    t->scale = TAB_SEGMENTS / (xmax - xmin);
+    t->exact = 0;
+    for (uint8_t seg = 0; seg < TAB_SEGMENTS; seg++) {
+        if (tab_fit_segment(t, seg, tol)) t->exact |= 1U << seg;
+    }
+    // The table plugs into tinyexpr as a closure, so every te_eval user works unchanged
+    te_variable vars[] = {{"x", var, TE_VARIABLE, 0}, {"tab", tab_eval, TE_CLOSURE1, t}};
+    te_expr *wrapper = te_compile("tab(x)", vars, 2, 0);
+    if (wrapper == NULL) {
+        free(t);
+        return NULL;
+    }
+    *tab = t;
+    return wrapper;
+}
+
+void tab_free(Tabulation *tab) {
+    if (!tab) return;
+    te_free(tab->expr);
+    free(tab);
+}
+
+uint8_t tab_fitted_segments(const Tabulation *tab) {
+    uint8_t n = 0;
+    for (uint8_t seg = 0; seg < TAB_SEGMENTS; seg++) {
+        if (!(tab->exact & (1U << seg))) n++;
+    }
+    return n;
+}
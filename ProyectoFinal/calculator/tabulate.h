@@ -0,0 +1,37 @@
+#ifndef TABULATE_H_
+#define TABULATE_H_
+
+#include <stdint.h>
+#include "../tinyexpr/tinyexpr.h"
+
+// Piecewise cubic approximation of a compiled expression. The range is split
+// into TAB_SEGMENTS equal segments, each interpolated at its Chebyshev nodes
+// and stored in power form, so a lookup costs an index computation and three
+// multiply-adds instead of a full te_eval of the tree. The table is allocated
+// by tab_compile and released by tab_free, it takes no RAM while unused.
+#define TAB_SEGMENTS 16
+#define TAB_DEGREE 3
+
+typedef struct tabulation {
+    te_expr *expr;              // Original tree, serves x outside the table and exact segments
+    double *var;                // Variable expr is bound to
+    double xmin;
+    double scale;               // Segments per unit of x
+    uint16_t exact;             // Bit per segment that missed the error bound, e.g. a discontinuity
+    double coef[TAB_SEGMENTS][TAB_DEGREE + 1];
+} Tabulation;
+
+// Fits expr over [xmin, xmax]. Segments where the fit is off by more than
+// tol at any check point, or f is undefined, keep using the tree. Returns a
+// tree that evaluates through the table, bound to the same variable, and
+// stores the table in *tab. The table takes ownership of expr. Returns NULL
+// and leaves expr alone when out of memory.
+te_expr *tab_compile(te_expr *expr, double *var, double xmin, double xmax, double tol, Tabulation **tab);
+
+// Frees the original tree and the table, not the tree tab_compile returned.
+void tab_free(Tabulation *tab);
+
+// Segments served from the polynomial table.
+uint8_t tab_fitted_segments(const Tabulation *tab);
+
+#endif /* TABULATE_H_ */
@@ -54,78 +54,97 @@
 // MCU Clock Speed - MUST be defined correctly for the delay functions to work.
 #define F_CPU	16000000UL
 
+#include <stddef.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include <util/delay.h>
 
 #include "ST7735_commands.h"
 #include "../SPI/spilib.h"
 #include "../pindefs.h"
+#include "../tick/tick.h"
 
 
-// Display controller setup code. Run once before issuing any data commands to
-// the display.
-// This code is based on the according Adafruit library, but greatly shortened
-// and simplified at the expense of efficiency. Comments inside this function
-// point at the original places where these commands were derived from. Check
-// there to learn more!
-void ST7735_init(void)
-{
-	// Reset display once before trying anything else.
-	// Required by the driver IC!
-	DDRD |= PIN_RST;		// reset as output, too
-	TFT_RST_H();	// reset high
-	_delay_ms(500);
-	TFT_RST_L();	// reset low
-	_delay_ms(500);
-	TFT_RST_H();	// reset high
-	_delay_ms(500);
-	
-	
-	
-	// This is like Adafruit_ST7735::initR - start there to follow the program
-	// flow and understand this command sequence!
-	
+// Display controller setup commands, after the Adafruit init tables. Each
+// entry is the command, its number of parameters or'ed with ST7735_DELAY
+// when a wait follows, the parameters and the wait in ms.
+// The waits are the datasheet's: 120 ms after SLPOUT before the power and
+// gamma settings take, none after NORON and DISPON. SWRESET is left out,
+// the hardware reset just before does the same.
+#define ST7735_DELAY 0x80
+static const uint8_t ST7735_init_cmds[] PROGMEM = {
 	// Initialisation sequence Rcmd1
-	wc(ST7735_SWRESET); _delay_ms(150);
-	wc(ST7735_SLPOUT);  _delay_ms(500);
-	wc(ST7735_FRMCTR1); wd(0x01); wd(0x2C); wd(0x2D);
-	wc(ST7735_FRMCTR2); wd(0x01); wd(0x2C); wd(0x2D);
-	wc(ST7735_FRMCTR3); wd(0x01); wd(0x2C); wd(0x2D); wd(0x01); wd(0x2C); wd(0x2D);
-	wc(ST7735_INVCTR);  wd(0x07);
-	wc(ST7735_PWCTR1);  wd(0xA2); wd(0x02); wd(0x84);
-	wc(ST7735_PWCTR2);  wd(0xC5);
-	wc(ST7735_PWCTR3);  wd(0x0A); wd(0x00);
-	wc(ST7735_PWCTR4);  wd(0x8A); wd(0x2A);
-	wc(ST7735_PWCTR5);  wd(0x8A); wd(0xEE);
-	wc(ST7735_VMCTR1);  wd(0x0E);
-	wc(ST7735_INVOFF);
-	wc(ST7735_MADCTL);  wd(0xC8);
-	wc(ST7735_COLMOD);  wd(0x05);
-	
+	ST7735_SLPOUT,  ST7735_DELAY, 120,
+	ST7735_FRMCTR1, 3, 0x01, 0x2C, 0x2D,
+	ST7735_FRMCTR2, 3, 0x01, 0x2C, 0x2D,
+	ST7735_FRMCTR3, 6, 0x01, 0x2C, 0x2D, 0x01, 0x2C, 0x2D,
+	ST7735_INVCTR,  1, 0x07,
+	ST7735_PWCTR1,  3, 0xA2, 0x02, 0x84,
+	ST7735_PWCTR2,  1, 0xC5,
+	ST7735_PWCTR3,  2, 0x0A, 0x00,
+	ST7735_PWCTR4,  2, 0x8A, 0x2A,
+	ST7735_PWCTR5,  2, 0x8A, 0xEE,
+	ST7735_VMCTR1,  1, 0x0E,
+	ST7735_INVOFF,  0,
+	ST7735_COLMOD,  1, 0x05,
 	// Initialisation sequence Rcmd2red
-	wc(ST7735_CASET);   wd(0x00); wd(0x00); wd(0x00); wd(0x7F);
-	wc(ST7735_RASET);   wd(0x00); wd(0x00); wd(0x00); wd(0x9F);
-	
+	ST7735_CASET,   4, 0x00, 0x00, 0x00, 0x7F,
+	ST7735_RASET,   4, 0x00, 0x00, 0x00, 0x9F,
 	// Initialisation sequence Rcmd3
-	wc(ST7735_GMCTRP1);	wd(0x02); wd(0x1c); wd(0x07); wd(0x12);
-	wd(0x37); wd(0x32); wd(0x29); wd(0x2D);
-	wd(0x29); wd(0x25); wd(0x2B); wd(0x39);
-	wd(0x00); wd(0x01); wd(0x03); wd(0x10);
-	wc(ST7735_GMCTRN1);	wd(0x03); wd(0x1d); wd(0x07); wd(0x06);
-	wd(0x2E); wd(0x2C); wd(0x29); wd(0x2D);
-	wd(0x2E); wd(0x2E); wd(0x37); wd(0x3F);
-	wd(0x00); wd(0x00); wd(0x02); wd(0x10);
-	wc(ST7735_NORON);   _delay_ms(10);
-	wc(ST7735_DISPON);  _delay_ms(100);
-	
-	// Change MADCTL color filter
-	wc(ST7735_MADCTL);  wd(0xC0);
-	
-	// Set rotation to widescreen (horizontal).
+	ST7735_GMCTRP1, 16, 0x02, 0x1c, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2D,
+	                    0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10,
+	ST7735_GMCTRN1, 16, 0x03, 0x1d, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D,
+	                    0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10,
+	// Set rotation to widescreen (horizontal), RGB color filter.
 	// (0,0) is in the top left corner.
 	// x extends to the right.
 	// y extends to the bottom.
 	// Compare Adafruit_ST7735::setRotation and the datasheet for more info.
-	wc(ST7735_MADCTL);
-	wd(MADCTL_MX | MADCTL_MV | MADCTL_RGB);
-}
\ No newline at end of file
+	ST7735_MADCTL,  1, MADCTL_MX | MADCTL_MV | MADCTL_RGB,
+	// Make all 160 lines one scroll area, no fixed areas. The panel's lines are
+	// the screen's columns in this rotation, so scrolling moves the picture
+	// sideways. See setScrollOffset in graphic_shapes.c.
+	ST7735_VSCRDEF, 6, 0x00, 0x00,		// Top fixed area
+	                   0x00, 0xA0,		// Scroll area, 160 lines
+	                   0x00, 0x00,		// Bottom fixed area
+	ST7735_NORON,   0,
+	ST7735_DISPON,  0,
+};
+
+// Next command of the table, the reset comes first
+static const uint8_t *ST7735_init_next = NULL;
+
+
+void ST7735_init(void)
+{
+	tick_seq_run(ST7735_init_step);
+}
+
+
+uint8_t ST7735_init_step(void)
+{
+	if (ST7735_init_next == NULL) {
+		// Hardware reset, required by the driver IC. The pulse must be
+		// at least 10 us long, and the controller takes up to 120 ms to
+		// come out of it.
+		TFT_RST_OUT();
+		TFT_RST_L();
+		_delay_us(10);
+		TFT_RST_H();
+		ST7735_init_next = ST7735_init_cmds;
+		return 120;
+	}
+	// Send commands up to the next one that needs a wait
+	while (ST7735_init_next < ST7735_init_cmds + sizeof(ST7735_init_cmds)) {
+		uint8_t cmd = pgm_read_byte(ST7735_init_next++);
+		uint8_t args = pgm_read_byte(ST7735_init_next++);
+		wc(cmd);
+		for (uint8_t i = 0; i < (args & ~ST7735_DELAY); i++) {
+			wd(pgm_read_byte(ST7735_init_next++));
+		}
+		if (args & ST7735_DELAY) return pgm_read_byte(ST7735_init_next++);
+	}
+	// Over, the next init starts with a reset again
+	ST7735_init_next = NULL;
+	return TICK_SEQ_DONE;
+}
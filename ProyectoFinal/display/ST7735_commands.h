@@ -54,6 +54,8 @@
 #ifndef _ST7735_COMMANDS_H_
 #define _ST7735_COMMANDS_H_
 
+#include <stdint.h>
+
 
 // TFT controller commands
 #define ST7735_SWRESET 0x01
@@ -68,6 +70,8 @@
 #define ST7735_CASET   0x2A
 #define ST7735_RASET   0x2B
 #define ST7735_RAMWR   0x2C
+#define ST7735_VSCRDEF 0x33
+#define ST7735_VSCRSADD 0x37
 
 #define ST7735_FRMCTR1 0xB1
 #define ST7735_FRMCTR2 0xB2
@@ -116,5 +120,9 @@
 // the display.
 void ST7735_init(void);
 
+// The same setup split into steps that do not wait, for tick_seq_poll. Each
+// returns the ms to wait before the next one, or TICK_SEQ_DONE.
+uint8_t ST7735_init_step(void);
+
 
 #endif // _ST7735_COMMANDS_H_
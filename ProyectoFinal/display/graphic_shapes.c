@@ -70,6 +70,7 @@
 
 #include "graphic_shapes.h"
 #include "ST7735_commands.h"
+#include "../prof/prof.h"
 
 #define swap(a, b) { int16_t t = a; a = b; b = t; }
 
@@ -77,8 +78,17 @@
 
 /* Basic routines */
 
+// Current hardware scroll start line
+static uint8_t scroll_offset = 0;
+
 void drawPixel(int16_t x, int16_t y, uint16_t color)
 {
+	// Clip, lines may start or end outside the screen
+	if (x < 0 || x >= TFT_WIDTH || y < 0 || y >= TFT_HEIGHT) return;
+	// Translate screen column to RAM column while the picture is scrolled
+	x += scroll_offset;
+	if (x >= TFT_WIDTH) x -= TFT_WIDTH;
+	
 	// set address window
 	wc(ST7735_CASET); 	// Column addr set
 	wd(0x00);
@@ -107,6 +117,48 @@ void drawPixelRGB(uint8_t x, uint8_t y, uint8_t r, uint8_t g, uint8_t b) {
 
 
 
+void setScrollOffset(uint8_t offset)
+{
+	scroll_offset = offset % TFT_WIDTH;
+	wc(ST7735_VSCRSADD);
+	wd(0x00);
+	wd(scroll_offset);
+}
+
+
+uint8_t getScrollOffset(void)
+{
+	return scroll_offset;
+}
+
+
+
+void setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
+{
+	wc(ST7735_CASET);	// Column addr set
+	wd(0x00);
+	wd(x0);				// XSTART
+	wd(0x00);
+	wd(x1);				// XEND
+	
+	wc(ST7735_RASET);	// Row addr set
+	wd(0x00);
+	wd(y0);				// YSTART
+	wd(0x00);
+	wd(y1);				// YEND
+	
+	wc(ST7735_RAMWR);	// write to RAM
+}
+
+
+void pushColor(uint16_t color)
+{
+	wd(color >> 8);
+	wd(color & 0xff);
+}
+
+
+
 /* Advanced routines - straight lines */
 
 void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
@@ -173,16 +225,36 @@ void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 	drawFastVLine(x+w-1, y, h, color);
 }
 
+// Fills RAM columns x0 to x1 and rows y0 to y1 through one address window
+static void fillWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint16_t color)
+{
+	setAddrWindow(x0, y0, x1, y1);
+	wr(color, (uint16_t) (x1 - x0 + 1) * (y1 - y0 + 1));
+}
+
 void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-	for (int16_t i=x; i<x+w; i++) {
-		drawFastVLine(i, y, h, color);
+	// Clip
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x + w > TFT_WIDTH) w = TFT_WIDTH - x;
+	if (y + h > TFT_HEIGHT) h = TFT_HEIGHT - y;
+	if (w <= 0 || h <= 0) return;
+	// Screen columns to RAM columns, the part past the last one wraps
+	x += scroll_offset;
+	if (x >= TFT_WIDTH) x -= TFT_WIDTH;
+	if (x + w > TFT_WIDTH) {
+		fillWindow(0, y, x + w - TFT_WIDTH - 1, y + h - 1, color);
+		w = TFT_WIDTH - x;
 	}
+	fillWindow(x, y, x + w - 1, y + h - 1, color);
 }
 
 void fillScreen(uint16_t color)
 {
+	PROF_BEGIN(PROF_FILLSCREEN);
 	fillRect(0, 0, TFT_WIDTH, TFT_HEIGHT, color);
+	PROF_END(PROF_FILLSCREEN);
 }
 
 
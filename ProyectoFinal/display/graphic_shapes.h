@@ -86,6 +86,24 @@ void drawPixelRGB(uint8_t x, uint8_t y, uint8_t r, uint8_t g, uint8_t b);
 
 
 
+// Scrolls the whole picture by setting the scroll start line. Screen column x
+// then shows controller RAM column (x + offset) % TFT_WIDTH, and every drawing
+// routine keeps using screen coordinates.
+void setScrollOffset(uint8_t offset);
+uint8_t getScrollOffset(void);
+
+
+
+// Opens the controller RAM window from column x0, row y0 to column x1, row y1
+// for writing. The pixels that follow with pushColor fill it row by row, left
+// to right in RAM columns. The scroll offset is not applied.
+void setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+
+// Writes the next pixel of the window opened by setAddrWindow.
+void pushColor(uint16_t color);
+
+
+
 /* Advanced routines - straight lines */
 
 // Draws a 1 pixel thin straight vertical line.
@@ -0,0 +1,132 @@
+#include "text.h"
+#include "graphic_shapes.h"
+#include "../SPI/spilib.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(addr) (*(addr))
+#endif
+
+#define TEXT_FIRST_CHAR ' '
+#define TEXT_LAST_CHAR '~'
+
+// Classic 5x7 font of the Adafruit GFX library, printable ASCII. One byte
+// per column, left to right, bit 0 is the top row and bit 7 the descender.
+static const uint8_t text_font[][5] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00},     //   !
+    {0x00, 0x07, 0x00, 0x07, 0x00}, {0x14, 0x7F, 0x14, 0x7F, 0x14},     // " #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},     // $ %
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00},     // & '
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, {0x00, 0x41, 0x22, 0x1C, 0x00},     // ( )
+    {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},     // * +
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08},     // , -
+    {0x00, 0x00, 0x60, 0x60, 0x00}, {0x20, 0x10, 0x08, 0x04, 0x02},     // . /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},     // 0 1
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33},     // 2 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, {0x27, 0x45, 0x45, 0x45, 0x39},     // 4 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},     // 6 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E},     // 8 9
+    {0x00, 0x00, 0x14, 0x00, 0x00}, {0x00, 0x40, 0x34, 0x00, 0x00},     // : ;
+    {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},     // < =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06},     // > ?
+    {0x3E, 0x41, 0x5D, 0x59, 0x4E}, {0x7C, 0x12, 0x11, 0x12, 0x7C},     // @ A
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},     // B C
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41},     // D E
+    {0x7F, 0x09, 0x09, 0x09, 0x01}, {0x3E, 0x41, 0x41, 0x51, 0x73},     // F G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},     // H I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41},     // J K
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, {0x7F, 0x02, 0x1C, 0x02, 0x7F},     // L M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},     // N O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E},     // P Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, {0x26, 0x49, 0x49, 0x49, 0x32},     // R S
+    {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},     // T U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F},     // V W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, {0x03, 0x04, 0x78, 0x04, 0x03},     // X Y
+    {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},     // Z [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F},     // \ ]
+    {0x04, 0x02, 0x01, 0x02, 0x04}, {0x40, 0x40, 0x40, 0x40, 0x40},     // ^ _
+    {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},     // ` a
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28},     // b c
+    {0x38, 0x44, 0x44, 0x28, 0x7F}, {0x38, 0x54, 0x54, 0x54, 0x18},     // d e
+    {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},     // f g
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00},     // h i
+    {0x20, 0x40, 0x40, 0x3D, 0x00}, {0x7F, 0x10, 0x28, 0x44, 0x00},     // j k
+    {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},     // l m
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38},     // n o
+    {0xFC, 0x18, 0x24, 0x24, 0x18}, {0x18, 0x24, 0x24, 0x18, 0xFC},     // p q
+    {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},     // r s
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C},     // t u
+    {0x1C, 0x20, 0x40, 0x20, 0x1C}, {0x3C, 0x40, 0x30, 0x40, 0x3C},     // v w
+    {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},     // x y
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00},     // z {
+    {0x00, 0x00, 0x77, 0x00, 0x00}, {0x00, 0x41, 0x36, 0x08, 0x00},     // | }
+    {0x02, 0x01, 0x02, 0x04, 0x02},                                     // ~
+};
+
+static char text_glyph_char(char c) {
+    return c >= TEXT_FIRST_CHAR && c <= TEXT_LAST_CHAR ? c : '?';
+}
+
+// Font bits of view row gy, bit gx set for a foreground pixel
+static uint8_t text_glyph_row(char c, uint8_t gy) {
+    const uint8_t *columns = text_font[c - TEXT_FIRST_CHAR];
+    uint8_t bits = 0;
+    for (uint8_t gx = 0; gx < 5; gx++) {
+        if (pgm_read_byte(&columns[gx]) & (1 << gy)) bits |= 1 << gx;
+    }
+    return bits;
+}
+
+// Sends window columns [c0, c1) of glyph c, its window starting at RAM
+// column col, row row. col is negative for the part past a wrap. Window rows
+// go up the screen and window columns right, which on the rotated panel is
+// from the last view row up and from the last view column left: the glyph
+// goes back to front, in runs of one color straight from the font.
+static void text_send(char c, uint16_t fg, uint16_t bg, int16_t col, uint8_t row, uint8_t c0, uint8_t c1) {
+    uint16_t run_color = bg;
+    uint8_t run = 0;
+    setAddrWindow(col + c0, row, col + c1 - 1, row + TEXT_CHAR_HEIGHT - 1);
+    for (int8_t gy = TEXT_CHAR_HEIGHT - 1; gy >= 0; gy--) {
+        uint8_t bits = text_glyph_row(c, gy);
+        for (uint8_t i = c0; i < c1; i++) {
+            uint16_t color = bits & (1 << (TEXT_CHAR_WIDTH - 1 - i)) ? fg : bg;
+            if (color != run_color) {
+                wr(run_color, run);
+                run_color = color;
+                run = 0;
+            }
+            run++;
+        }
+    }
+    wr(run_color, run);
+}
+
+int16_t drawText(int16_t x, int16_t y, const char *str, uint16_t fg, uint16_t bg) {
+    int16_t x0 = x;
+    // Screen row of the window's first row, the glyph's last view row
+    int16_t row = TFT_HEIGHT - y - TEXT_CHAR_HEIGHT;
+    for (; *str; str++, x += TEXT_CHAR_WIDTH) {
+        if (x < 0 || x + TEXT_CHAR_WIDTH > TFT_WIDTH || row < 0 || row + TEXT_CHAR_HEIGHT > TFT_HEIGHT) continue;
+        char c = text_glyph_char(*str);
+        // Screen column of the glyph's last view column, moved to RAM
+        // columns while scrolled. Past the last one it wraps around.
+        int16_t col = TFT_WIDTH - x - TEXT_CHAR_WIDTH + getScrollOffset();
+        if (col >= TFT_WIDTH) col -= TFT_WIDTH;
+        if (col + TEXT_CHAR_WIDTH > TFT_WIDTH) {
+            uint8_t split = TFT_WIDTH - col;
+            text_send(c, fg, bg, col, row, 0, split);
+            text_send(c, fg, bg, col - TFT_WIDTH, row, split, TEXT_CHAR_WIDTH);
+        } else {
+            text_send(c, fg, bg, col, row, 0, TEXT_CHAR_WIDTH);
+        }
+    }
+    return x - x0;
+}
+
+int16_t textWidth(const char *str) {
+    int16_t width = 0;
+    while (*str++) width += TEXT_CHAR_WIDTH;
+    return width;
+}
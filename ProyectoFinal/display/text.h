@@ -0,0 +1,26 @@
+#ifndef TEXT_H_
+#define TEXT_H_
+
+#include <stdint.h>
+
+// Text on the TFT in a 5x7 font with descenders, kept in flash. Every glyph
+// is sent as one address window burst of TEXT_CHAR_WIDTH x TEXT_CHAR_HEIGHT
+// pixels, its spacing column included, so text is drawn opaque over bg. The
+// pixels go out in runs of one color straight from the font, no RAM is
+// spent on expanded glyphs.
+//
+// Coordinates are the viewer's: the panel is mounted rotated by 180 degrees,
+// so view x is screen column TFT_WIDTH - 1 - x, as PLOT_COL, and view y is
+// screen row TFT_HEIGHT - 1 - y. Glyphs are sent last pixel first to read
+// upright.
+#define TEXT_CHAR_WIDTH 6
+#define TEXT_CHAR_HEIGHT 8
+
+// Draws str with its top left corner at view (x, y). Characters outside the
+// font show as '?', glyphs not entirely on screen are skipped. Returns the
+// width in pixels.
+int16_t drawText(int16_t x, int16_t y, const char *str, uint16_t fg, uint16_t bg);
+// Width in pixels of str
+int16_t textWidth(const char *str);
+
+#endif /* TEXT_H_ */
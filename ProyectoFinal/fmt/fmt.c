@@ -0,0 +1,334 @@
+#include "fmt.h"
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define memcpy_P memcpy
+#endif
+
+// Shortest digits come from Grisu2 (Loitsch, "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers"). A float and its neighbours are
+// scaled by a cached power of ten into 64-bit fixed point, and digits are
+// produced until the result is inside the interval that rounds back to the
+// float. Grisu2 always round trips and is the shortest representation for
+// all but a few values. 64 bits leave a wide margin over the 24-bit mantissa.
+
+typedef struct diy_fp {
+    uint64_t f;
+    int16_t e;
+} DiyFp;
+
+// 10^d for d = FMT_POW10_MIN, FMT_POW10_MIN + 8, ... as normalized 64-bit
+// mantissas, enough to bring every float into range. Kept in flash.
+#define FMT_POW10_MIN (-40)
+static const DiyFp cached_pow10[] PROGMEM = {
+    {0x8B61313BBABCE2C6ULL, -196},  // 1e-40
+    {0xCFB11EAD453994BAULL, -170},  // 1e-32
+    {0x9ABE14CD44753B53ULL, -143},  // 1e-24
+    {0xE69594BEC44DE15BULL, -117},  // 1e-16
+    {0xABCC77118461CEFDULL, -90},   // 1e-8
+    {0x8000000000000000ULL, -63},   // 1e0
+    {0xBEBC200000000000ULL, -37},   // 1e8
+    {0x8E1BC9BF04000000ULL, -10},   // 1e16
+    {0xD3C21BCECCEDA100ULL, 16},    // 1e24
+    {0x9DC5ADA82B70B59EULL, 43},    // 1e32
+    {0xEB194F8E1AE525FDULL, 69},    // 1e40
+    {0xAF298D050E4395D7ULL, 96},    // 1e48
+};
+
+// Upper 64 bits of the 128-bit product, rounded
+static DiyFp diy_mul(DiyFp x, DiyFp y) {
+    uint64_t a = x.f >> 32, b = x.f & 0xFFFFFFFF;
+    uint64_t c = y.f >> 32, d = y.f & 0xFFFFFFFF;
+    uint64_t bc = b * c, ad = a * d;
+    uint64_t mid = ((b * d) >> 32) + (ad & 0xFFFFFFFF) + (bc & 0xFFFFFFFF) + (1UL << 31);
+    DiyFp r = {a * c + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64};
+    return r;
+}
+
+static DiyFp diy_normalize(DiyFp x) {
+    while (!(x.f >> 56)) {
+        x.f <<= 8;
+        x.e -= 8;
+    }
+    while (!(x.f >> 63)) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+// Walks the last digit down while that gets closer to the exact value and
+// stays inside the round trip interval
+static void grisu_round(char * digits, uint8_t len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w) {
+    while (rest < wp_w && delta - rest >= ten_kappa
+           && (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        digits[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+// Shortest digits of a positive finite float, value = digits * 10^K
+static uint8_t grisu2(float value, char * digits, int16_t * K) {
+    union {float f; uint32_t u;} bits = {value};
+    uint32_t frac = bits.u & 0x7FFFFF;
+    uint8_t bexp = bits.u >> 23;
+    DiyFp v = {frac, -149};
+    if (bexp) {
+        v.f |= 0x800000;
+        v.e = bexp - 150;
+    }
+    // Midpoints to the neighbouring floats, the gap below is half as wide
+    // right above a power of two
+    DiyFp plus = {(v.f << 1) + 1, v.e - 1};
+    plus = diy_normalize(plus);
+    DiyFp minus = {(v.f << 1) - 1, v.e - 1};
+    if (!frac && bexp > 1) {
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    // Pick 10^d so the scaled upper bound has a binary exponent in [-60, -32],
+    // d >= (-61 - e) * log10(2)
+    int16_t k = ((int32_t) (-61 - plus.e) * 78913 + 262143) >> 18;
+    DiyFp c;
+    memcpy_P(&c, &cached_pow10[(k - FMT_POW10_MIN + 7) / 8], sizeof(DiyFp));
+    *K = -(FMT_POW10_MIN + (k - FMT_POW10_MIN + 7) / 8 * 8);
+
+    DiyFp w = diy_mul(diy_normalize(v), c);
+    DiyFp wp = diy_mul(plus, c);
+    DiyFp wm = diy_mul(minus, c);
+    // Stay strictly inside the interval despite the rounding of the products
+    wm.f++;
+    wp.f--;
+    uint64_t delta = wp.f - wm.f;
+    uint64_t wp_w = wp.f - w.f;
+
+    uint8_t shift = -wp.e;
+    uint64_t one = (uint64_t) 1 << shift;
+    uint32_t p1 = wp.f >> shift;
+    uint64_t p2 = wp.f & (one - 1);
+    uint8_t len = 0;
+    // Integer part, at most 10 digits
+    uint32_t div = 1000000000;
+    int8_t kappa = 10;
+    while (kappa > 0) {
+        uint8_t d = p1 / div;
+        p1 %= div;
+        if (d || len) digits[len++] = '0' + d;
+        kappa--;
+        uint64_t rest = ((uint64_t) p1 << shift) + p2;
+        if (rest <= delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, rest, (uint64_t) div << shift, wp_w);
+            return len;
+        }
+        div /= 10;
+    }
+    // Fractional part
+    uint64_t unit = 1;
+    while (true) {
+        p2 *= 10;
+        delta *= 10;
+        unit *= 10;
+        uint8_t d = p2 >> shift;
+        if (d || len) digits[len++] = '0' + d;
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *K += kappa;
+            grisu_round(digits, len, delta, p2, one, wp_w * unit);
+            return len;
+        }
+    }
+}
+
+// Ratio below which the smaller part of a complex value is dropped, the
+// relative precision of a float
+#define FMT_COMPLEX_NOISE 1.2e-7
+
+// Layout of the digits: value = 0.digits * 10^point
+typedef struct fmt_layout {
+    uint8_t n;          // Significant digits
+    int16_t point;      // Decimal point position relative to the first digit
+} FmtLayout;
+
+// Digits fixed notation can show in avail characters, 0 if it cannot
+static uint8_t fixed_digits(FmtLayout l, uint8_t avail) {
+    if (l.point < FMT_MIN_FIXED_POINT || l.point > avail) return 0;
+    if (l.point <= 0) {
+        // "0." and the leading zeros come first
+        int16_t room = avail - 2 + l.point;
+        if (room <= 0) return 0;
+        return l.n < room ? l.n : room;
+    }
+    if (l.n <= l.point) return l.n;
+    if (l.point == avail) return l.point;
+    return l.n < avail - 1 ? l.n : avail - 1;
+}
+
+// Engineering exponent and digits before the point
+static int16_t eng_exponent(FmtLayout l, uint8_t * int_digits) {
+    int16_t e = l.point - 1;
+    int16_t ee = e >= 0 ? e / 3 * 3 : -((2 - e) / 3 * 3);
+    *int_digits = e - ee + 1;
+    return ee;
+}
+
+static uint8_t exponent_length(int16_t ee) {
+    uint8_t len = ee < 0 ? 2 : 1;
+    if (ee < 0) ee = -ee;
+    for (; ee >= 10; ee /= 10) len++;
+    return len + 1;
+}
+
+// Digits engineering notation can show in avail characters, 0 if it cannot
+static uint8_t eng_digits(FmtLayout l, uint8_t avail) {
+    uint8_t int_digits;
+    int16_t ee = eng_exponent(l, &int_digits);
+    int16_t room = avail - exponent_length(ee);
+    if (room < int_digits) return 0;
+    if (l.n <= int_digits) return l.n;
+    if (room == int_digits) return int_digits;
+    return l.n < room - 1 ? l.n : room - 1;
+}
+
+// Rounds half up to keep digits, dropping trailing zeros
+static void round_digits(char * digits, FmtLayout * l, uint8_t keep) {
+    if (keep < l->n) {
+        bool carry = digits[keep] >= '5';
+        l->n = keep;
+        for (int8_t i = keep - 1; carry && i >= 0; i--) {
+            if (digits[i] == '9') {
+                digits[i] = '0';
+            } else {
+                digits[i]++;
+                carry = false;
+            }
+        }
+        if (carry) {
+            // 9.99 -> 10.0, all digits are now zeros
+            digits[0] = '1';
+            l->n = 1;
+            l->point++;
+        }
+    }
+    while (l->n > 1 && digits[l->n - 1] == '0') l->n--;
+}
+
+static char * put_digits(char * out, const char * digits, uint8_t from, uint8_t to, uint8_t n) {
+    for (uint8_t i = from; i < to; i++) *out++ = i < n ? digits[i] : '0';
+    return out;
+}
+
+uint8_t fmt_double(double value, char * buf, uint8_t width) {
+    float v = value;
+    char * out = buf;
+    if (v != v) {
+        strcpy(buf, "NaN");
+        return 3;
+    }
+    if (v < 0) {
+        *out++ = '-';
+        v = -v;
+        width--;
+    }
+    if (v > 3.4028235e38f) {
+        strcpy(out, "inf");
+        return out - buf + 3;
+    }
+    if (v == 0) {
+        strcpy(buf, "0");
+        return 1;
+    }
+    char digits[12];
+    int16_t K;
+    FmtLayout l;
+    l.n = grisu2(v, digits, &K);
+    l.point = l.n + K;
+
+    // Rounding can carry into a new digit and change the layout, so settle
+    // it again until nothing has to be cut
+    bool fixed;
+    while (true) {
+        uint8_t fd = fixed_digits(l, width);
+        uint8_t ed = eng_digits(l, width);
+        fixed = fd && fd >= ed;
+        uint8_t keep = fixed ? fd : ed;
+        if (!keep || keep >= l.n) break;
+        round_digits(digits, &l, keep);
+    }
+
+    if (fixed) {
+        if (l.point <= 0) {
+            *out++ = '0';
+            *out++ = '.';
+            for (int16_t i = l.point; i < 0; i++) *out++ = '0';
+            out = put_digits(out, digits, 0, l.n, l.n);
+        } else {
+            out = put_digits(out, digits, 0, l.point, l.n);
+            if (l.n > l.point) {
+                *out++ = '.';
+                out = put_digits(out, digits, l.point, l.n, l.n);
+            }
+        }
+    } else {
+        uint8_t int_digits;
+        int16_t ee = eng_exponent(l, &int_digits);
+        out = put_digits(out, digits, 0, int_digits, l.n);
+        if (l.n > int_digits) {
+            *out++ = '.';
+            out = put_digits(out, digits, int_digits, l.n, l.n);
+        }
+        *out++ = 'e';
+        if (ee < 0) {
+            *out++ = '-';
+            ee = -ee;
+        }
+        char exp[4];
+        uint8_t len = 0;
+        do {
+            exp[len++] = '0' + ee % 10;
+            ee /= 10;
+        } while (ee);
+        while (len) *out++ = exp[--len];
+    }
+    *out = '\0';
+    return out - buf;
+}
+
+uint8_t fmt_complex(double re, double im, char * buf, uint8_t width) {
+    double are = re < 0 ? -re : re, aim = im < 0 ? -im : im;
+    if (re != re || im != im) return fmt_double(re + im, buf, width);
+    if (aim <= are * FMT_COMPLEX_NOISE) im = 0;
+    else if (are <= aim * FMT_COMPLEX_NOISE) re = 0;
+    if (im == 0) return fmt_double(re, buf, width);
+
+    // Magnitude of the imaginary part in the fewest characters every value
+    // fits in, "i" alone for 1. The real part gets the rest.
+    char ibuf[FMT_MIN_WIDTH + 1];
+    uint8_t li = 0;
+    if (aim != 1) li = fmt_double(aim, ibuf, FMT_MIN_WIDTH);
+    char * out = buf;
+    if (re != 0) {
+        uint8_t room = width - 2 - li;  // The sign and the i
+        uint8_t lr = fmt_double(re, out, room > FMT_MIN_WIDTH ? room : FMT_MIN_WIDTH);
+        // Not even the least precision of both fits, the larger part is
+        // shown alone
+        if (lr > room) return are < aim ? fmt_complex(0, im, buf, width) : fmt_double(re, buf, width);
+        out += lr;
+        *out++ = im < 0 ? '-' : '+';
+    } else if (im < 0) {
+        *out++ = '-';
+    }
+    memcpy(out, ibuf, li);
+    out += li;
+    *out++ = 'i';
+    *out = '\0';
+    return out - buf;
+}
@@ -0,0 +1,28 @@
+#ifndef FMT_H_
+#define FMT_H_
+
+#include <stdint.h>
+
+// Width of one LCD line
+#define FMT_LCD_WIDTH 16
+// Narrowest width every value fits in, e.g. "-123e-45"
+#define FMT_MIN_WIDTH 8
+// Fixed notation is only used down to 0.000d, smaller values go to engineering
+#define FMT_MIN_FIXED_POINT (-3)
+
+// Formats value as a 32-bit float into buf (at least width + 1 bytes) with the
+// fewest digits that read back to the same float, in fixed or engineering
+// notation, whichever shows more significant digits within width. Digits that
+// do not fit are rounded off. No allocation and no printf. Returns the length.
+uint8_t fmt_double(double value, char * buf, uint8_t width);
+
+// Formats re + im*i into buf (at least width + 1 bytes) as "a+bi", "a-bi",
+// "bi" or just "a" for real values, in width characters from FMT_LCD_WIDTH
+// up. A part smaller than the float precision of the other is rounding noise
+// and dropped, e.g. the imaginary part of exp(i*pi). The imaginary part is
+// written in the fewest characters, the real part gets the rest. When both do
+// not fit even then, e.g. -1.1e-13-4.4e-19i, only the larger part is shown.
+// Returns the length.
+uint8_t fmt_complex(double re, double im, char * buf, uint8_t width);
+
+#endif /* FMT_H_ */
@@ -1,4 +1,6 @@
 #include "lcd_i2c.h"
+#include "../prof/prof.h"
+#include "../tick/tick.h"
 
 /// These are Bit-Masks for the special signals and background light
 #define PCF_RS  0x01
@@ -44,7 +46,15 @@ void lcd_init(uint8_t addr) {
     _backlight = 0;
 }
 
+// Step of lcd_begin_step to run next
+static uint8_t _beginStep = 0;
+
 void lcd_begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
+    lcd_config(cols, lines, dotsize);
+    tick_seq_run(lcd_begin_step);
+}
+
+void lcd_config(uint8_t cols, uint8_t lines, uint8_t dotsize) {
     // cols ignored !
     _numlines = lines;
 
@@ -58,40 +68,50 @@ void lcd_begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
     if ((dotsize != 0) && (lines == 1)) {
         _displayfunction |= LCD_5x10DOTS;
     }
+}
 
-    // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
-    // according to datasheet, we need at least 40ms after power rises above 2.7V
-    // before sending commands. Arduino can turn on way befor 4.5V so we'll wait 50
-    i2c_init();
+uint8_t lcd_begin_step(void) {
+    switch (_beginStep++) {
+    case 0:
+        // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
+        // according to datasheet, we need at least 40ms after power rises above 2.7V
+        // before sending commands. Arduino can turn on way befor 4.5V so we'll wait 50
+        i2c_init();
 
-    // initializing the display
-    _write2Wire(0x00, 0x0, false);
-    _delay_us(50000);
+        // initializing the display
+        _write2Wire(0x00, 0x0, false);
+        return 50;
 
     // put the LCD into 4 bit mode according to the hitachi HD44780 datasheet figure 26, pg 47
-    _sendNibble(0x03, RSMODE_CMD);
-    _delay_us(4500); 
-    _sendNibble(0x03, RSMODE_CMD);
-    _delay_us(4500); 
-    _sendNibble(0x03, RSMODE_CMD);
-    _delay_us(150);
-    // finally, set to 4-bit interface
-    _sendNibble(0x02, RSMODE_CMD);
-
-    // finally, set # lines, font size, etc.
-    _command(LCD_FUNCTIONSET | _displayfunction);  
-
-    // turn the display on with no cursor or blinking default
-    _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;  
-    lcd_display();
-
-    // clear it off
-    lcd_clear();
-
-    // Initialize to default text direction (for romance languages)
-    _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-    // set the entry mode
-    _command(LCD_ENTRYMODESET | _displaymode);
+    case 1:
+        _sendNibble(0x03, RSMODE_CMD);
+        return 5;   // > 4.1ms
+    case 2:
+        _sendNibble(0x03, RSMODE_CMD);
+        return 1;   // > 100us
+    case 3:
+        _sendNibble(0x03, RSMODE_CMD);
+        // finally, set to 4-bit interface
+        _sendNibble(0x02, RSMODE_CMD);
+
+        // finally, set # lines, font size, etc.
+        _command(LCD_FUNCTIONSET | _displayfunction);  
+
+        // turn the display on with no cursor or blinking default
+        _displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;  
+        lcd_display();
+
+        // clear it off, this command takes a long time!
+        _command(LCD_CLEARDISPLAY);
+        return 2;
+    default:
+        // Initialize to default text direction (for romance languages)
+        _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+        // set the entry mode
+        _command(LCD_ENTRYMODESET | _displaymode);
+        _beginStep = 0;
+        return TICK_SEQ_DONE;
+    }
 }
 
 void lcd_clear() {
@@ -204,7 +224,10 @@ size_t lcd_print_shift(const char * s, uint8_t row) {
 }
 
 size_t lcd_print(const char * s) {
-    return lcd_write(s, strlen(s));
+    PROF_BEGIN(PROF_LCD_PRINT);
+    size_t n = lcd_write(s, strlen(s));
+    PROF_END(PROF_LCD_PRINT);
+    return n;
 }
 
 size_t lcd_write(const char * buffer, size_t size)
@@ -73,6 +73,10 @@
 
 void lcd_init(uint8_t addr);
 void lcd_begin(uint8_t cols, uint8_t lines, uint8_t dotsize);
+// lcd_begin without waiting: lcd_config takes the settings, then the
+// lcd_begin_step sequence is run with tick_seq_poll
+void lcd_config(uint8_t cols, uint8_t lines, uint8_t dotsize);
+uint8_t lcd_begin_step(void);
 
 void lcd_clear();
 void lcd_home();
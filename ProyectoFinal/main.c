@@ -1,35 +1,63 @@
 #define F_CPU 16000000UL
-#define BAUD_RATE 9600
+#define BAUD_RATE 500000UL
 #define TX_BUFFLEN 128
 #define RX_BUFFLEN 128
 #define LCD_ADDR 0x3F
 #define EQ_BUFF_LENGTH 32
 
 //#define SERIAL_DEBUG
-//#define DRAW_POINTS
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "pindefs.h"
+#if defined(SERIAL_DEBUG) && defined(SPI_USART)
+#error "SPI_USART drives the TFT from the USART, SERIAL_DEBUG needs it"
+#endif
 #ifdef SERIAL_DEBUG
 #include "usart/usart.h"
+#include "usart/protocol.h"
+#include "memstat/memstat.h"
 #endif
 #include "i2c/i2c.h"
 #include "SPI/spilib.h"
 
 #include "calculator/calculator.h"
+#include "calculator/solver.h"
+#include "calculator/history.h"
+#include "calculator/symbols.h"
+#include "calculator/grid.h"
+#include "calculator/curve.h"
+#include "calculator/strip.h"
+#include "fmt/fmt.h"
 #include "tinyexpr/tinyexpr.h"
 #include "lcd_i2c/lcd_i2c.h"
 #include "display/ST7735_commands.h"
 #include "display/graphic_shapes.h"
+#include "prof/prof.h"
+#include "tick/tick.h"
 
 void errorHalt(char* msg);
 void lcd_moveCursor(uint8_t x, uint8_t y);
+void range_prompt(const char * label);
+bool uses_variable(const char * expression, const char * name);
+bool needs_variable(const char * expression, const char * name);
+void cycle_variable(void);
+void analyze_plot(void);
+void integrate_plot(void);
+void toggle_tabulation(void);
+void draw_grid(double xmin, double xmax, double ymin, double ymax);
+bool tft_poll(void);
+#ifdef SERIAL_DEBUG
+void strip_sample(float ymin, float ymax, float value);
+#endif
+void print_entry(const HistEntry * entry);
 const char equals_sign[] = "=";
 char teclas[17] = {'x', '/', '=', '0', '.', '*', '9', '8', '7', '-', '6','5','4','+','3','2','1'};
 char teclas_extra[16][7] =	{"pi", "d", ")", "(", "log10(", "sqrt(", "^", "x", "ln(", "atan(", "acos(", "asin(", "exp(", "tan(", "cos(", "sin("};
@@ -53,7 +81,46 @@ volatile uint8_t second_keypad=0;
 uint8_t lcd_pos[] = {0, 0};
 Node * keypad_ll;
 char * plot_operation;
+Plot plot;
+// Function of x and y on screen, drawn instead of the plot while grid.expr is set
+Grid grid;
+// Parametric or polar curve on screen, drawn instead of the plot while curve.fx is set
+Curve curve;
+// Strip chart on screen while strip.n_traces is set, of the curve or of
+// samples received over USART
+Strip strip;
+// Display setup sequences, run on the tick. The TFT is usable once tft_poll
+// returns true.
+TickSeq lcd_seq, tft_seq;
+bool tft_ready = false;
 volatile bool ask_for_range = false;
+// Plot navigation: with a plot on screen and nothing typed, an empty "="
+// enters it and these keys pan, zoom, integrate and toggle tabulation. An
+// empty "=" or any other key leaves it, the key is then typed as usual.
+const char nav_keys[] = "468250";
+#define NAV_TOGGLE '='
+volatile bool nav_mode = false;
+// Variables the x key cycles through in plot mode. The keypad interrupt
+// counts the presses, the main loop rewrites the line.
+const char plot_variables[] = "xyt";
+volatile uint8_t cycle_count = 0;
+volatile bool plot_shown = false;
+volatile char nav_key = 0;
+// Index of the derivative overlay added by analyze_plot, 0 if none
+uint8_t derivative_func = 0;
+// Explicit plot window: 0 while at the "Rango:" prompt, then the 1-based index
+// of the bound being typed. An empty "Rango:" walks through xmin..ymax.
+#define RANGE_ERROR 0xFF
+const char * const range_labels[] = {"xmin:", "xmax:", "ymin:", "ymax:"};
+uint8_t range_field = 0;
+double range_vals[4];
+bool range_autoscale = true;
+// Calc mode history. With nothing typed, "d" steps back through it and "="
+// repeats the entry shown, or the newest one. x types "ans".
+History history;
+#define RECALL_NONE 0xFF
+volatile char recall_key = 0;
+uint8_t recall_age = RECALL_NONE;
 
 
 int main(void) {
@@ -63,31 +130,41 @@ int main(void) {
     struct USART_configuration config = {BAUD_RATE, 8, 0, 1};
     USART_Init(config);
     _delay_ms(10);
+    proto_strip_sink = strip_sample;
 #endif
-    // Init I2C and LCD
+    PROF_INIT();
+    // The display waits run on the tick, activate interrupts
+    tick_init();
+    sei();
+    // Init I2C and SPI, start the LCD and TFT setup sequences together
     i2c_init();
     lcd_init(LCD_ADDR);
-    lcd_begin(16, 2, LCD_5x8DOTS);
-	lcd_createChar(0, pi_char);
-    // Init SPI and TFT
+    lcd_config(16, 2, LCD_5x8DOTS);
+    tick_seq_start(&lcd_seq, lcd_begin_step);
     spi_init();
-    ST7735_init();
+    tick_seq_start(&tft_seq, ST7735_init_step);
+    // User variables and functions, read from EEPROM on first use
+    sym_init();
+    // Keys echo on the LCD, the keypad waits for it. The TFT goes on in the
+    // main loop.
+    while (!tick_seq_poll(&lcd_seq)) {
+        tft_poll();
+    }
+	lcd_createChar(0, pi_char);
+    lcd_setBacklight(255);
+    // Back from CGRAM to the start of the first line
+    lcd_setCursor(0, 0);
     // Init keypads
     keypad_ll = init_keypad();
-    // Activate interrupts
-    sei();
-    // Configure TFT
-    fillScreen(ST7735_BACKGROUND);
-    drawMajorAxes(ST7735_WHITE);
-    // Configure LCD
-    lcd_setBacklight(255);
-    lcd_home();
-    lcd_clear();
-    
-    uint8_t y_vals[TFT_WIDTH];
     
     //Main loop
     while (true) {
+        tft_poll();
+        strip_poll(&strip);
+#ifdef SERIAL_DEBUG
+        // Answer remote evaluation requests
+        proto_poll();
+#endif
         // Check for plot or calc mode
         plot_mode = PINB & STATE_SELECT;
         if (plot_mode) {
@@ -95,6 +172,71 @@ int main(void) {
         } else {
             LED_OFF();
             ask_for_range=false;
+            nav_mode = false;
+        }
+        // Pan or zoom the plot on screen
+        if (nav_key) {
+            char key = nav_key;
+            nav_key = 0;
+            if (key == NAV_TOGGLE) {
+                lcd_clear();
+                if (nav_mode) lcd_print("Navegar");
+                key = 0;
+            }
+            // A function of x and y only switches between heatmap and curve.
+            // A curve of t is charted against time with 5, which pauses and
+            // resumes the chart after, and 0 goes back to the curve.
+            if (grid.expr || curve.fx) {
+                if (grid.expr && key == '0') {
+                    grid.mode = grid.mode == GRID_HEATMAP ? GRID_CONTOUR : GRID_HEATMAP;
+                    draw_grid(grid.xmin, grid.xmax, grid.ymin, grid.ymax);
+                }
+                if (curve.fx && key == '5') {
+                    if (strip.curve) {
+                        strip.running = !strip.running;
+                    } else if (strip_begin_curve(&strip, &curve, curve.tmin, curve.tmax)) {
+                        lcd_home();
+                        lcd_clear();
+                        lcd_print("Error en funcion");
+                    }
+                }
+                if (curve.fx && key == '0' && strip.curve) {
+                    strip_stop(&strip);
+                    curve_draw(&curve, curve.tmin, curve.tmax, curve.xmin, curve.xmax,
+                               curve.ymin, curve.ymax, false);
+                }
+                key = 0;
+            }
+            switch (key) {
+                case '4': plot_pan(&plot, -PLOT_PAN_STEP); break;
+                case '6': plot_pan(&plot, PLOT_PAN_STEP); break;
+                case '8': plot_zoom(&plot, true); break;
+                case '2': plot_zoom(&plot, false); break;
+                case '5': integrate_plot(); break;
+                case '0': toggle_tabulation(); break;
+                case 'd': analyze_plot(); break;
+            }
+        }
+        // x pressed after a variable
+        while (cycle_count) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                cycle_count--;
+            }
+            cycle_variable();
+        }
+        // Browse or repeat the calc history
+        if (recall_key) {
+            char key = recall_key;
+            recall_key = 0;
+            if (key == 'd' && history.count) {
+                recall_age = recall_age + 1 < history.count ? recall_age + 1 : 0;
+                print_entry(hist_get(&history, recall_age));
+            }
+            else if (key == '=' && history.count) {
+                hist_repeat(&history, recall_age == RECALL_NONE ? 0 : recall_age);
+                recall_age = RECALL_NONE;
+                print_entry(hist_get(&history, 0));
+            }
         }
         // Is an operation result queued?
         if (equals_flag) {
@@ -104,44 +246,133 @@ int main(void) {
                 if (!ask_for_range) {
                     plot_operation = decode(keypad_ll, keypad_ll_len);
                     ask_for_range = true;
-                    lcd_setCursor(0,1);
-                    lcd_print("Rango:");
-                    lcd_setCursor(7, 1);
+                    range_field = 0;
+                    range_prompt("Rango:");
                 }
                 // Range received, plot function
                 else {
                     char * range_str = decode(keypad_ll, keypad_ll_len);
-                    double range_val = atof(range_str);
-                    if (range_val == 0.0){
+                    int parse_err = 0;
+                    double range_val = *range_str ? te_interp(range_str, &parse_err) : 0.0;
+                    bool do_plot = false;
+                    // A function instead of a range: overlay it on the previous ones, or
+                    // y(t) after x(t)
+                    if (!range_field && parse_err && (uses_variable(range_str, "x") || needs_variable(range_str, "t"))) {
+                        char * joined = (char *)malloc(strlen(plot_operation) + strlen(range_str) + 2);
+                        if (joined == NULL) errorHalt("Allocation\n");
+                        strcpy(joined, plot_operation);
+                        strcat(joined, ",");
+                        strcat(joined, range_str);
+                        free(plot_operation);
+                        plot_operation = joined;
+                        range_prompt("Rango:");
+                    }
+                    else if (parse_err) {
+                        range_field = RANGE_ERROR;
+                    }
+                    // Symmetric range, y window fit to the functions
+                    else if (!range_field && *range_str) {
+                        range_vals[0] = -fabs(range_val);
+                        range_vals[1] = fabs(range_val);
+                        range_autoscale = true;
+                        do_plot = true;
+                    }
+                    // Empty range: ask for each bound, an empty ymin autoscales
+                    else if (!range_field) {
+                        range_field = 1;
+                        range_prompt(range_labels[0]);
+                    }
+                    else if (!*range_str && range_field != 3) {
+                        range_field = RANGE_ERROR;
+                    }
+                    else if (!*range_str) {
+                        range_autoscale = true;
+                        do_plot = true;
+                    }
+                    else {
+                        range_vals[range_field - 1] = range_val;
+                        if (range_field == 4) {
+                            range_autoscale = false;
+                            do_plot = true;
+                        } else {
+                            range_prompt(range_labels[range_field++]);
+                        }
+                    }
+                    free(range_str);
+                    if (!do_plot && range_field != RANGE_ERROR) {
+                        keypad_ll_len = 0;
+                        equals_flag = false;
+                        continue;
+                    }
+                    // A plot typed that fast still needs the TFT ready
+                    while (!tft_poll());
+                    // The chart may be sampling the curve about to be replaced
+                    strip_stop(&strip);
+                    if (range_field == RANGE_ERROR || range_vals[0] >= range_vals[1]
+                            || (!range_autoscale && range_vals[2] >= range_vals[3])) {
                         // Error state.
                         lcd_home();
                         lcd_clear();
                         lcd_print("Error en rango.");
+                    } else if (needs_variable(plot_operation, "t")) {
+                        plot_free(&plot);
+                        grid_free(&grid);
+                        // The range is the span of t, a full window gets one turn
+                        double tmin = range_autoscale ? range_vals[0] : -M_PI;
+                        double tmax = range_autoscale ? range_vals[1] : M_PI;
+                        plot_shown = !curve_compile(&curve, plot_operation)
+                                && !curve_draw(&curve, tmin, tmax, range_vals[0], range_vals[1],
+                                               range_vals[2], range_vals[3], range_autoscale);
+                        if (!plot_shown) {
+                            curve_free(&curve);
+                            lcd_home();
+                            lcd_clear();
+                            lcd_print("Error en funcion");
+                        }
+                    } else if (needs_variable(plot_operation, "y")) {
+                        plot_free(&plot);
+                        curve_free(&curve);
+                        grid.mode = GRID_HEATMAP;
+                        // The y window keeps the scale of x unless given
+                        if (range_autoscale) {
+                            range_vals[3] = (range_vals[1] - range_vals[0]) * TFT_HEIGHT / TFT_WIDTH / 2;
+                            range_vals[2] = -range_vals[3];
+                        }
+                        if (grid_compile(&grid, plot_operation)) {
+                            plot_shown = false;
+                            lcd_home();
+                            lcd_clear();
+                            lcd_print("Error en funcion");
+                        } else {
+                            draw_grid(range_vals[0], range_vals[1], range_vals[2], range_vals[3]);
+                        }
                     } else {
-                        uint8_t err;
-                        err = calculateFunctionPixels(y_vals, plot_operation, range_val);
+                        grid_free(&grid);
+                        curve_free(&curve);
+                        uint8_t err = plot_compile(&plot, plot_operation);
+                        if (!err) err = calculateFunctionPixels(&plot, range_vals[0], range_vals[1],
+                                                                range_vals[2], range_vals[3], range_autoscale);
                         if (err) {
                             // Error state.
+                            plot_free(&plot);
+                            plot_shown = false;
                             lcd_home();
                             lcd_clear();
                             lcd_print("Error en funcion");
                         } else {
-                            fillScreen(ST7735_BACKGROUND);
-                            drawMajorAxes(ST7735_WHITE);
-                            #ifdef DRAW_POINTS
-                            for (int i = 0; i < TFT_WIDTH; i++) {
-                                drawPixel(i, y_vals[i], ST7735_OLDGREEN);
-                            }                            
-                            #else
-                            for (int i = 1; i < TFT_WIDTH; i++) {
-                                drawLine(TFT_WIDTH - i, y_vals[i - 1], TFT_WIDTH - (i + 1), y_vals[i], ST7735_OLDGREEN);
-                            }                        
-                            #endif
+                            // Keep the plot compiled for panning and zooming
+                            plot_draw(&plot);
+                            plot_shown = true;
+                            derivative_func = 0;
                         }
-                    }                                           
+                    }
                     free(plot_operation);
-                    free(range_str);
-                    ask_for_range = false;        
+                    range_field = 0;
+                    ask_for_range = false;
+    #ifdef SERIAL_DEBUG
+                    MEMSTAT_REPORT();
+                    PROF_DUMP();
+    #endif
                 }
                 keypad_ll_len = 0;
                 equals_flag = false;
@@ -159,18 +390,26 @@ int main(void) {
                 lcd_setCursor(0, 1);
                 // Evaluate expression
                 int err_flag = 0;
-                double res = te_interp(operation, &err_flag);
+                double res = 0, res_im = 0;
+                PROF_BEGIN(PROF_TE_COMPILE);
+                te_expr *expr = hist_compile(&history, operation, &err_flag);
+                PROF_END(PROF_TE_COMPILE);
+                if (expr) {
+                    PROF_BEGIN(PROF_TE_EVAL);
+                    // sqrt(-1) or ln(-2) give complex results instead of NaN
+                    res = te_eval_complex(expr, &res_im);
+                    PROF_END(PROF_TE_EVAL);
+                    // The history keeps its own copy of the tree
+                    hist_push(&history, operation, expr, res, res_im);
+                    te_free(expr);
+                }
+                recall_age = RECALL_NONE;
                 // If error, display NaN on LCD
                 if(err_flag) {
                     lcd_print("NaN");
                 } else {
-                    char sres[16];
-                    // TODO: Define display logic
-                    if (res > 10e6) {
-                        dtostre(res, sres, 2, 0x04);
-                    } else {
-                        dtostrf(res, 3, 2, sres);
-                    }
+                    char sres[FMT_LCD_WIDTH + 1];
+                    fmt_complex(res, res_im, sres, FMT_LCD_WIDTH);
                     lcd_print(sres);
     #ifdef SERIAL_DEBUG
                     USART_Transmit_char('=');
@@ -181,6 +420,10 @@ int main(void) {
                 keypad_ll_len = 0; 
                 equals_flag = false;
                 free(operation);
+    #ifdef SERIAL_DEBUG
+                MEMSTAT_REPORT();
+                PROF_DUMP();
+    #endif
             }           
         }             
     }
@@ -232,11 +475,13 @@ ISR (TIMER0_OVF_vect){
         keypad_button_index = 13;
     }
     // Input columns, output rows
-	DDRD &= ~((1<<2)  + (1<<3) + (1<<4) + (1<<5));
+	DDRD &= ~KEYPAD_COLS_D;
+	KEYPAD_COL2_DDR &= ~KEYPAD_COL2;
 	DDRC &= ~((1<<0)  + (1<<1) + (1<<2) + (1<<3));
 	DDRD |= (1<<6) + (1<<7);
 	DDRB |= (1<<0) + (1<<1);
-	PORTD |= (1<<2)  + (1<<3) + (1<<4) + (1<<5);
+	PORTD |= KEYPAD_COLS_D;
+	KEYPAD_COL2_PORT |= KEYPAD_COL2;
 	PORTC |= (1<<0)  + (1<<1) + (1<<2) + (1<<3);
 	PORTD &= ~((1<<6) + (1<<7));
 	PORTB &= ~((1<<0) + (1<<1));
@@ -251,7 +496,7 @@ ISR (TIMER0_OVF_vect){
 			keypad_button_index += 1;
 			second_keypad=0;
 		}
-		else if (!(PIND&(1<<4))){
+		else if (!(KEYPAD_COL2_PIN&KEYPAD_COL2)){
 			keypad_button_index += 2;
 			second_keypad=0;
 		}
@@ -280,9 +525,11 @@ ISR (TIMER0_OVF_vect){
     // Input rows, output columns
 	DDRD &= ~((1<<6) + (1<<7));
 	DDRB &= ~((1<<0) + (1<<1));
-	DDRD |= (1<<2)  + (1<<3) + (1<<4) + (1<<5);
+	DDRD |= KEYPAD_COLS_D;
+	KEYPAD_COL2_DDR |= KEYPAD_COL2;
 	DDRC |= (1<<0)  + (1<<1) + (1<<2) + (1<<3);
-	PORTD &= ~((1<<2) + (1<<3) + (1<<4) + (1<<5));
+	PORTD &= ~KEYPAD_COLS_D;
+	KEYPAD_COL2_PORT &= ~KEYPAD_COL2;
 	PORTC &= ~((1<<0)  + (1<<1) + (1<<2) + (1<<3));
 	PORTD |= (1<<6) + (1<<7);
 	PORTB |= (1<<0) + (1<<1);
@@ -293,7 +540,47 @@ ISR (TIMER0_OVF_vect){
 	char *keypad_input=&teclas[keypad_button_index];
 	char *keypad_input_extra=teclas_extra[keypad_button_index-1];
     
-    if ((!((*keypad_input=='=')&!keypad_ll_len))){
+    if (plot_mode && plot_shown && !keypad_ll_len && !ask_for_range && keypad_button_index) {
+        if (!second_keypad && *keypad_input == '=') {
+            nav_mode = !nav_mode;
+            nav_key = NAV_TOGGLE;
+            return;
+        }
+        if (nav_mode && !second_keypad && strchr(nav_keys, *keypad_input)) {
+            nav_key = *keypad_input;
+            return;
+        }
+        nav_mode = false;
+        // "d" analyzes the plot instead of clearing the empty line
+        if (second_keypad && !strcmp(keypad_input_extra, "d")) {
+            nav_key = 'd';
+            return;
+        }
+    }
+    // In calc mode an empty "=" or "d" goes to the history
+    if (!plot_mode && !keypad_ll_len && keypad_button_index) {
+        if ((!second_keypad && *keypad_input == '=') || (second_keypad && !strcmp(keypad_input_extra, "d"))) {
+            recall_key = second_keypad ? 'd' : '=';
+            return;
+        }
+    }
+    // There is no x in calc mode, the key stands for the last answer
+    if (!plot_mode && second_keypad && !strcmp(keypad_input_extra, "x")) {
+        keypad_input_extra = HIST_ANS_NAME;
+    }
+    
+    // There are no y and t keys: in plot mode x typed right after a variable
+    // cycles it through x, y and t
+    if (plot_mode && second_keypad && !strcmp(keypad_input_extra, "x") && keypad_ll_len) {
+        char last = last_node(keypad_ll)->valor;
+        if (last && strchr(plot_variables, last)) {
+            cycle_count++;
+            return;
+        }
+    }
+    
+    // An empty '=' only means something at the range prompt
+    if ((!((*keypad_input=='=')&!keypad_ll_len&!ask_for_range))){
 
 		if ((*keypad_input == '=')&(!second_keypad)){
 			equals_flag=1;
@@ -304,7 +591,7 @@ ISR (TIMER0_OVF_vect){
 			if (!keypad_ll_len && !ask_for_range){
                 lcd_clear();
             }               
-            if(!second_keypad||strcmp(teclas_extra[keypad_button_index-1], "x")||(plot_mode)) {
+            if(!second_keypad||strcmp(keypad_input_extra, "x")||(plot_mode)) {
 			    // Process first keypad
                 if ((strcmp(teclas_extra[keypad_button_index-1], "d"))|!second_keypad){
 			        if (!second_keypad){
@@ -322,7 +609,7 @@ ISR (TIMER0_OVF_vect){
 			        else {
                         if (strcmp(teclas_extra[keypad_button_index-1], "pi")){
                             // NO ES PI
-                            lcd_print(teclas_extra[keypad_button_index-1]);
+                            lcd_print(keypad_input_extra);
                         }
                         else{
                             write((uint8_t)0);
@@ -348,6 +635,222 @@ ISR (TIMER0_OVF_vect){
 	}
 }
 
+// Advances the TFT setup, and paints the empty plot once it is over
+bool tft_poll(void) {
+    if (!tft_ready && tick_seq_poll(&tft_seq)) {
+        fillScreen(ST7735_BACKGROUND);
+        drawMajorAxes(ST7735_WHITE);
+        tft_ready = true;
+    }
+    return tft_ready;
+}
+
+#ifdef SERIAL_DEBUG
+// Charts a sample received over USART. A chart of the curve or in another
+// window is replaced by a new one, the plot underneath no longer takes keys.
+void strip_sample(float ymin, float ymax, float value) {
+    double sample = value;
+    if (!tft_poll()) return;
+    if (strip.curve || !strip.n_traces || strip.ymin != ymin || strip.ymax != ymax) {
+        if (strip_begin(&strip, 1, ymin, ymax)) return;
+        plot_shown = false;
+    }
+    strip_push(&strip, &sample);
+}
+#endif
+
+// Clears the second LCD line and leaves the cursor after the label
+void range_prompt(const char * label) {
+    lcd_setCursor(0, 1);
+    lcd_print("                ");
+    lcd_setCursor(0, 1);
+    lcd_print(label);
+    lcd_setCursor(strlen(label) + 1, 1);
+}
+
+// Whether expression compiles with name bound as a variable and reads it, as
+// the parser sees it: "exp(1)" holds the letter x but does not use it.
+bool uses_variable(const char * expression, const char * name) {
+    double value = 0;
+    te_variable vars[] = {{name, &value}};
+    te_expr *expr = te_compile(expression, vars, 1, 0);
+    bool uses = te_uses(expr, &value);
+    te_free(expr);
+    return uses;
+}
+
+// Whether expression needs name as a variable besides x: it does not compile
+// as a function of x alone, user symbols included, but does with name bound
+// and reads it. A stored y or t is then a constant, not a plot variable.
+bool needs_variable(const char * expression, const char * name) {
+    double x = 0, value = 0;
+    te_variable vars[] = {{"x", &x}, {name, &value}};
+    te_expr *expr = te_compile(expression, vars, 1, 0);
+    if (expr) {
+        te_free(expr);
+        return false;
+    }
+    expr = te_compile(expression, vars, 2, 0);
+    bool needs = te_uses(expr, &value);
+    te_free(expr);
+    return needs;
+}
+
+// Steps the variable at the end of the line to the next of plot_variables
+void cycle_variable(void) {
+    char s_disp[2] = {'\0', '\0'};
+    // The keypad interrupt appends to the line, read and replace its last
+    // value without it running in between
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        if (!keypad_ll_len) return;
+        Node * last = last_node(keypad_ll);
+        const char * next = last->valor ? strchr(plot_variables, last->valor) : NULL;
+        if (!next) return;
+        last->valor = next[1] ? next[1] : plot_variables[0];
+        s_disp[0] = last->valor;
+    }
+    _command(LCD_CURSORSHIFT | LCD_CURSORMOVE | LCD_MOVELEFT);
+    lcd_print(s_disp);
+}
+
+// Shows a history entry like a fresh result, its text and "=" on the first
+// line and the result on the second
+void print_entry(const HistEntry * entry) {
+    char sres[FMT_LCD_WIDTH + 1];
+    fmt_complex(entry->result, entry->result_im, sres, FMT_LCD_WIDTH);
+    char text[HIST_SHOWN_LEN + 1];
+    strncpy(text, entry->text, HIST_SHOWN_LEN);
+    text[HIST_SHOWN_LEN] = '\0';
+    lcd_clear();
+    lcd_print(text);
+    lcd_setCursor(15, 0);
+    lcd_print(equals_sign);
+    lcd_setCursor(0, 1);
+    lcd_print(sres);
+#ifdef SERIAL_DEBUG
+    USART_Transmit_String((char *)entry->text);
+    USART_Transmit_char('=');
+    USART_Transmit_String(sres);
+    USART_Transmit_char('\n');
+#endif
+}
+
+// Evaluations used on the second LCD line, "!" when the budget ran out
+static void print_stats(const SolverStats * stats) {
+    char str[8];
+    utoa(stats->evals, str, 10);
+    lcd_setCursor(16 - strlen(str) - 1, 1);
+    lcd_print(stats->exhausted ? "!" : " ");
+    lcd_print(str);
+#ifdef SERIAL_DEBUG
+    USART_Transmit_String("evals ");
+    USART_Transmit_String(str);
+    if (stats->exhausted) USART_Transmit_String(" (budget)");
+    USART_Transmit_char('\n');
+#endif
+}
+
+// Prints "label" followed by as many values as fit on one LCD line. The end
+// of the second line is left for print_stats.
+static void print_values(uint8_t line, const char * label, const double * values, uint8_t n) {
+    uint8_t cols = line ? 11 : 16;
+    char str[17];
+    uint8_t len = strlen(label);
+    strcpy(str, label);
+    for (uint8_t i = 0; i < n; i++) {
+        char num[FMT_MIN_WIDTH + 1];
+        fmt_double(values[i], num, FMT_MIN_WIDTH);
+        if (len + strlen(num) + 1 > cols) break;
+        strcat(str, " ");
+        strcat(str, num);
+        len += strlen(num) + 1;
+    }
+    lcd_setCursor(0, line);
+    lcd_print(str);
+#ifdef SERIAL_DEBUG
+    USART_Transmit_String((char *)label);
+    for (uint8_t i = 0; i < n; i++) {
+        char num[FMT_LCD_WIDTH + 1];
+        fmt_double(values[i], num, FMT_LCD_WIDTH);
+        USART_Transmit_char(' ');
+        USART_Transmit_String(num);
+    }
+    USART_Transmit_char('\n');
+#endif
+}
+
+// Overlays the exact derivative of the first function and reports its zeros
+// (roots) and the zeros of the derivative (extrema), refined with Newton's
+// method from the sign changes in the plotted samples. Functions without a
+// derivative still get their roots, found with Brent's method.
+void analyze_plot(void) {
+    double zeros[SOLVER_MAX_ZEROS];
+    SolverStats stats = {SOLVER_ROOT_EVALS, 0, 0, false};
+    te_expr *df = te_derive(plot_source(&plot, 0), &plot.real_x);
+    lcd_clear();
+    uint8_t n = solver_plot_zeros(&plot, 0, df, zeros, SOLVER_MAX_ZEROS, &stats);
+    print_values(0, "R:", zeros, n);
+    if (!df) {
+        lcd_setCursor(0, 1);
+        lcd_print("Sin deriv.");
+    }
+    // The derivative samples seed the extrema search
+    else if (!derivative_func && plot_add(&plot, df)) {
+        // No room for another curve, roots only
+        te_free(df);
+    }
+    else {
+        if (!derivative_func) {
+            derivative_func = plot.n_funcs - 1;
+        } else {
+            te_free(df);
+        }
+        te_expr *d2f = te_derive(plot_source(&plot, derivative_func), &plot.real_x);
+        n = solver_plot_zeros(&plot, derivative_func, d2f, zeros, SOLVER_MAX_ZEROS, &stats);
+        print_values(1, "E:", zeros, n);
+        te_free(d2f);
+    }
+    print_stats(&stats);
+}
+
+// Integrates the first function over the plot window
+void integrate_plot(void) {
+    SolverStats stats = {SOLVER_INTEGRAL_EVALS, 0, 0, false};
+    double area = solver_plot_integral(&plot, 0, &stats);
+    lcd_clear();
+    print_values(0, "I:", &area, 1);
+    print_stats(&stats);
+}
+
+// Serves the first plot function from the piecewise cubic table, or back from
+// its tree
+void toggle_tabulation(void) {
+    lcd_clear();
+    if (plot.tab) {
+        plot_untabulate(&plot);
+        lcd_print("Tabla off");
+        return;
+    }
+    char str[8];
+    lcd_print("Tabla ");
+    utoa(plot_tabulate(&plot), str, 10);
+    lcd_print(str);
+    lcd_print("/");
+    utoa(TAB_SEGMENTS, str, 10);
+    lcd_print(str);
+}
+
+// Draws the function of x and y over the range, or reports it does not fit in memory
+void draw_grid(double xmin, double xmax, double ymin, double ymax) {
+    plot_shown = !grid_draw(&grid, xmin, xmax, ymin, ymax, grid.mode);
+    if (!plot_shown) {
+        grid_free(&grid);
+        lcd_home();
+        lcd_clear();
+        lcd_print("Error en funcion");
+    }
+}
+
 void errorHalt(char* msg) {
 #ifdef SERIAL_DEBUG
     USART_Transmit_String("Error: ");
@@ -0,0 +1,141 @@
+#include "memstat.h"
+
+#ifdef MEMSTAT
+
+#include <util/atomic.h>
+#include "../usart/usart.h"
+
+// Section boundaries provided by the linker script
+extern uint8_t __data_start, __data_end, __bss_start, __bss_end;
+extern uint8_t __stack;
+// avr-libc allocator internals: current break (0 before the first malloc) and free list
+extern char *__brkval;
+struct __freelist {
+    size_t sz;
+    struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+// Real allocator, reached through -Wl,--wrap=malloc -Wl,--wrap=free
+void *__real_malloc(size_t len);
+void __real_free(void *ptr);
+
+// avr-libc keeps the usable chunk size right before the returned pointer
+#define CHUNK_SIZE(PTR) (((size_t *)(PTR))[-1] + sizeof(size_t))
+
+static uint16_t heap_in_use = 0;
+static uint16_t heap_peak = 0;
+static uint16_t heap_top_peak = 0;
+static uint16_t alloc_failures = 0;
+
+// Paint everything between the end of .bss and RAMEND before main() runs.
+// .init1 executes before the stack pointer is used, so this has to be plain asm.
+void memstat_paint_stack(void) __attribute__((naked, used, section(".init1")));
+void memstat_paint_stack(void) {
+    __asm volatile (
+        "    ldi r30, lo8(_end)\n"
+        "    ldi r31, hi8(_end)\n"
+        "    ldi r24, %0\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:  st Z+, r24\n"
+        "2:  cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n"
+        :: "M" (STACK_CANARY)
+    );
+}
+
+static uint8_t * heap_top(void) {
+    return (uint8_t *) (__brkval ? __brkval : __malloc_heap_start);
+}
+
+uint16_t memstat_stack_unused(void) {
+    const uint8_t *p = heap_top();
+    uint16_t count = 0;
+    while (p <= &__stack && *p == STACK_CANARY) {
+        p++;
+        count++;
+    }
+    return count;
+}
+
+uint16_t memstat_stack_peak(void) {
+    const uint8_t *deepest = heap_top() + memstat_stack_unused();
+    if (deepest > &__stack) return 0;
+    return &__stack - deepest + 1;
+}
+
+void *__wrap_malloc(size_t len) {
+    void *ptr;
+    // The keypad ISR allocates too, keep the allocator and counters consistent
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ptr = __real_malloc(len);
+        if (ptr == NULL) {
+            alloc_failures++;
+        } else {
+            heap_in_use += CHUNK_SIZE(ptr);
+            if (heap_in_use > heap_peak) heap_peak = heap_in_use;
+            uint16_t top = heap_top() - (uint8_t *) __malloc_heap_start;
+            if (top > heap_top_peak) heap_top_peak = top;
+        }
+    }
+    return ptr;
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr == NULL) return;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        heap_in_use -= CHUNK_SIZE(ptr);
+        __real_free(ptr);
+    }
+}
+
+void memstat_collect(MemStats * stats) {
+    stats->data_size = &__data_end - &__data_start;
+    stats->bss_size = &__bss_end - &__bss_start;
+    uint16_t listed = 0, largest = 0;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        stats->heap_in_use = heap_in_use;
+        stats->heap_peak = heap_peak;
+        stats->heap_top_peak = heap_top_peak;
+        stats->alloc_failures = alloc_failures;
+        for (struct __freelist *fp = __flp; fp != NULL; fp = fp->nx) {
+            uint16_t chunk = fp->sz + sizeof(size_t);
+            listed += chunk;
+            if (chunk > largest) largest = chunk;
+        }
+    }
+    stats->heap_free_listed = listed;
+    stats->heap_largest_free = largest;
+    // 0 % when all free memory is one chunk, towards 100 % as it splinters
+    stats->heap_frag = listed ? 100 - (uint8_t) ((100UL * largest) / listed) : 0;
+    stats->stack_unused = memstat_stack_unused();
+    stats->stack_peak = memstat_stack_peak();
+}
+
+static void report_field(char * name, uint16_t value) {
+    char num[6];
+    USART_Transmit_String(name);
+    USART_Transmit_String(utoa(value, num, 10));
+}
+
+void memstat_report(void) {
+    MemStats stats;
+    memstat_collect(&stats);
+    report_field("mem data=", stats.data_size);
+    report_field(" bss=", stats.bss_size);
+    report_field(" heap=", stats.heap_in_use);
+    report_field("/", stats.heap_peak);
+    report_field(" top=", stats.heap_top_peak);
+    report_field(" free=", stats.heap_free_listed);
+    report_field("/", stats.heap_largest_free);
+    report_field(" frag=", stats.heap_frag);
+    report_field("% fail=", stats.alloc_failures);
+    report_field(" stack=", stats.stack_peak);
+    report_field(" gap=", stats.stack_unused);
+    USART_Transmit_char('\n');
+}
+
+#endif /* MEMSTAT */
@@ -0,0 +1,54 @@
+#ifndef MEMSTAT_H_
+#define MEMSTAT_H_
+
+// MEMSTAT is defined by the Debug configuration, which also links with
+// -Wl,--wrap=malloc -Wl,--wrap=free so every allocation is counted. The two
+// go together. Release builds keep neither the wrappers nor the stack
+// painting. The summary goes out over USART, so SERIAL_DEBUG must be enabled
+// in main.c as well.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Byte written over the free RAM between .bss and the stack at reset. Any byte
+// that still holds it has never been touched by the stack or the heap.
+#define STACK_CANARY 0xC5
+
+typedef struct mem_stats {
+    uint16_t data_size;         // Static .data bytes
+    uint16_t bss_size;          // Static .bss bytes
+    uint16_t heap_in_use;       // Bytes currently handed out by malloc (incl. headers)
+    uint16_t heap_peak;         // Largest heap_in_use ever seen
+    uint16_t heap_top_peak;     // Highest address the heap break ever reached, offset from heap start
+    uint16_t heap_free_listed;  // Bytes sitting in malloc's free list
+    uint16_t heap_largest_free; // Largest single chunk in malloc's free list
+    uint8_t heap_frag;          // Free list fragmentation, 0-100 %
+    uint16_t alloc_failures;    // malloc calls that returned NULL
+    uint16_t stack_peak;        // Deepest stack usage since reset
+    uint16_t stack_unused;      // Untouched bytes between heap top and deepest stack
+} MemStats;
+
+#ifdef MEMSTAT
+
+#define MEMSTAT_REPORT()    memstat_report()
+
+// Bytes of stack still holding the canary above the current heap top.
+uint16_t memstat_stack_unused(void);
+
+// Deepest stack usage (bytes below RAMEND) since reset.
+uint16_t memstat_stack_peak(void);
+
+// Fill a MemStats snapshot. Walks the malloc free list, call outside ISRs.
+void memstat_collect(MemStats * stats);
+
+// Transmits a one line memory summary over USART.
+void memstat_report(void);
+
+#else
+
+#define MEMSTAT_REPORT()
+
+#endif
+
+#endif /* MEMSTAT_H_ */
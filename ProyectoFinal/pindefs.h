@@ -3,13 +3,46 @@
 
 #include <avr/io.h>
 
+// Uncomment to drive the TFT from USART0 in Master SPI mode instead of the
+// SPI module, see SPI/spilib.h. The display then takes MOSI from TXD0 (PD1)
+// and SCK from XCK0 (PD4), and its reset moves to PB3. The third column of
+// the first keypad moves from PD4 to PB5, free without the SPI module.
+//#define SPI_USART
+
 // Pin configurations
 #define PIN_SCLK	(1 << PORTB5)
 #define STATE_SELECT (1 << PORTB4)
 #define PIN_MOSI	(1 << PORTB3)
 #define PIN_DC		(1 << PORTB2)
-#define PIN_RST		(1 << PORTD1)
 #define STATE_LED   (1 << PORTD0)
+#ifndef SPI_USART
+#define PIN_RST		(1 << PORTD1)
+#define PORT_RST	PORTD
+#define DDR_RST		DDRD
+#else
+#define PIN_USART_MOSI	(1 << PORTD1)
+#define PIN_USART_SCLK	(1 << PORTD4)
+#define PIN_RST		(1 << PORTB3)
+#define PORT_RST	PORTB
+#define DDR_RST		DDRB
+#endif
+
+// First keypad columns. Bits of port D and B are also their pin change
+// mask bits in PCMSK2 and PCMSK0.
+#define KEYPAD_COLS_D	((1 << PORTD2) | (1 << PORTD3) | (1 << PORTD5))
+#ifndef SPI_USART
+#define KEYPAD_COL2		(1 << PORTD4)
+#define KEYPAD_COL2_PORT	PORTD
+#define KEYPAD_COL2_DDR	DDRD
+#define KEYPAD_COL2_PIN	PIND
+#define KEYPAD_COL2_PCMSK	PCMSK2
+#else
+#define KEYPAD_COL2		(1 << PORTB5)
+#define KEYPAD_COL2_PORT	PORTB
+#define KEYPAD_COL2_DDR	DDRB
+#define KEYPAD_COL2_PIN	PINB
+#define KEYPAD_COL2_PCMSK	PCMSK0
+#endif
 
 #define SELECT_TFT()		(PORTB &= ~CS_TFT)	/* CS = L */
 #define	DESELECT_TFT()		(PORTB |= CS_TFT)	/* CS = H */
@@ -20,8 +53,9 @@
 #define TOGGLE_COMMAND()	(PORTB &= ~PIN_DC)	/* D/C = L */
 #define TOGGLE_DATA()		(PORTB |= PIN_DC)	/* D/C = H */
 
-#define TFT_RST_H()			(PORTD |= PIN_RST)	// Set TFT reset high
-#define TFT_RST_L()			(PORTD &= ~PIN_RST)	// Set TFT reset low
+#define TFT_RST_OUT()		(DDR_RST |= PIN_RST)	// Reset as output
+#define TFT_RST_H()			(PORT_RST |= PIN_RST)	// Set TFT reset high
+#define TFT_RST_L()			(PORT_RST &= ~PIN_RST)	// Set TFT reset low
 
 #define LED_ON()			(PORTD |= STATE_LED)
 #define LED_OFF()			(PORTD &= ~STATE_LED)
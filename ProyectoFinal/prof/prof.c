@@ -0,0 +1,96 @@
+#include "prof.h"
+
+#ifdef PROFILE
+
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "../usart/usart.h"
+#else
+#include <stdio.h>
+#include <time.h>
+#endif
+
+static ProfRecord prof_table[PROF_N_REGIONS];
+
+#ifdef __AVR__
+
+// Upper 16 bits of the timestamp, Timer1 provides the lower ones
+static volatile uint16_t prof_overflows = 0;
+
+ISR (TIMER1_OVF_vect) {
+    prof_overflows++;
+}
+
+void prof_init(void) {
+    // Normal mode, no prescaler: one tick per CPU cycle, overflow every 4.096 ms
+    TCCR1A = 0;
+    TCCR1B = (1 << CS10);
+    TCNT1 = 0;
+    TIMSK1 |= (1 << TOIE1);
+}
+
+uint32_t prof_now(void) {
+    uint16_t hi, lo;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        lo = TCNT1;
+        hi = prof_overflows;
+        // Overflow pending but not serviced yet, the counter already wrapped
+        if ((TIFR1 & (1 << TOV1)) && lo < 0x8000) hi++;
+    }
+    return ((uint32_t) hi << 16) | lo;
+}
+
+static void dump_field(uint32_t value) {
+    char num[11];
+    USART_Transmit_char(',');
+    USART_Transmit_String(ultoa(value, num, 10));
+}
+
+void prof_dump(void) {
+    for (uint8_t i = 0; i < PROF_N_REGIONS; i++) {
+        USART_Transmit_String("prof");
+        dump_field(i);
+        dump_field(prof_table[i].count);
+        dump_field(prof_table[i].total);
+        dump_field(prof_table[i].max);
+        USART_Transmit_char('\n');
+    }
+}
+
+#else
+
+void prof_init(void) {
+}
+
+uint32_t prof_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ts.tv_sec * 1000000000UL + (uint32_t) ts.tv_nsec;
+}
+
+void prof_dump(void) {
+    for (uint8_t i = 0; i < PROF_N_REGIONS; i++) {
+        printf("prof,%u,%lu,%lu,%lu\n", i, (unsigned long) prof_table[i].count,
+               (unsigned long) prof_table[i].total, (unsigned long) prof_table[i].max);
+    }
+}
+
+#endif /* __AVR__ */
+
+void prof_accumulate(uint8_t id, uint32_t start) {
+    uint32_t elapsed = prof_now() - start;
+    ProfRecord *rec = &prof_table[id];
+    rec->count++;
+    rec->total += elapsed;
+    if (elapsed > rec->max) rec->max = elapsed;
+}
+
+void prof_reset(void) {
+    memset(prof_table, 0, sizeof(prof_table));
+}
+
+#endif /* PROFILE */
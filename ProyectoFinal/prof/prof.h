@@ -0,0 +1,60 @@
+#ifndef PROF_H_
+#define PROF_H_
+
+// Uncomment to collect per-region timings. The table is dumped over USART, so
+// SERIAL_DEBUG must be enabled in main.c as well.
+//#define PROFILE
+
+#include <stdint.h>
+
+// Instrumented regions. Add new ones before PROF_N_REGIONS.
+enum prof_region {
+    PROF_TE_COMPILE,
+    PROF_TE_EVAL,
+    PROF_DRAWLINE,
+    PROF_FILLSCREEN,
+    PROF_LCD_PRINT,
+    PROF_N_REGIONS
+};
+
+// Ticks are CPU cycles on the device (Timer1, no prescaler) and nanoseconds on the host.
+typedef struct prof_record {
+    uint32_t count;
+    uint32_t total;
+    uint32_t max;
+} ProfRecord;
+
+#ifdef PROFILE
+
+#define PROF_INIT()         prof_init()
+#define PROF_BEGIN(ID)      uint32_t _prof_start_##ID = prof_now()
+#define PROF_END(ID)        prof_accumulate(ID, _prof_start_##ID)
+#define PROF_DUMP()         prof_dump()
+#define PROF_RESET()        prof_reset()
+
+// Start the free running timebase
+void prof_init(void);
+
+// Current timestamp in ticks
+uint32_t prof_now(void);
+
+// Add the time elapsed since start to a region
+void prof_accumulate(uint8_t id, uint32_t start);
+
+// Send the table as "prof,<id>,<count>,<total>,<max>" CSV lines
+void prof_dump(void);
+
+// Clear all regions
+void prof_reset(void);
+
+#else
+
+#define PROF_INIT()
+#define PROF_BEGIN(ID)
+#define PROF_END(ID)
+#define PROF_DUMP()
+#define PROF_RESET()
+
+#endif /* PROFILE */
+
+#endif /* PROF_H_ */
@@ -0,0 +1,59 @@
+#define F_CPU 16000000UL
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include "tick.h"
+
+static volatile uint16_t tick_ms = 0;
+
+ISR (TIMER2_COMPA_vect) {
+    tick_ms++;
+}
+
+void tick_init(void) {
+    // CTC, prescaler 128: 125 kHz, a compare match every 125 counts
+    TCCR2A = (1 << WGM21);
+    TCCR2B = (1 << CS22) | (1 << CS20);
+    OCR2A = 124;
+    TCNT2 = 0;
+    TIMSK2 |= (1 << OCIE2A);
+}
+
+uint16_t tick_now(void) {
+    uint16_t now;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        now = tick_ms;
+    }
+    return now;
+}
+
+bool tick_elapsed(uint16_t start, uint16_t ms) {
+    // The tick start fell anywhere within its millisecond, one more makes
+    // sure a whole ms has passed
+    return (uint16_t) (tick_now() - start) > ms;
+}
+
+void tick_seq_start(TickSeq *seq, TickStep step) {
+    seq->step = step;
+    seq->start = tick_now();
+    seq->wait = 0;
+}
+
+bool tick_seq_poll(TickSeq *seq) {
+    while (seq->wait != TICK_SEQ_DONE) {
+        // A zero wait runs the next step right away
+        if (seq->wait && !tick_elapsed(seq->start, seq->wait)) return false;
+        seq->wait = seq->step();
+        seq->start = tick_now();
+    }
+    return true;
+}
+
+void tick_seq_run(TickStep step) {
+    uint8_t wait;
+    while ((wait = step()) != TICK_SEQ_DONE) {
+        while (wait--) _delay_ms(1);
+    }
+}
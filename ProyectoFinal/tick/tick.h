@@ -0,0 +1,36 @@
+#ifndef TICK_H_
+#define TICK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Millisecond timebase on Timer2, free of the keypad (Timer0) and the
+// profiler (Timer1). It wraps every 65.5 s, compare differences only.
+
+// Return value of a sequence step once the sequence is over
+#define TICK_SEQ_DONE 0xFF
+
+// One step of a timed sequence: does its work without waiting and returns
+// the milliseconds to let pass before the next step, or TICK_SEQ_DONE
+typedef uint8_t (*TickStep)(void);
+
+typedef struct tick_seq {
+    TickStep step;
+    uint16_t start;         // Tick of the last step
+    uint8_t wait;           // Milliseconds it asked for
+} TickSeq;
+
+// Starts the timebase. Interrupts must be enabled for it to run.
+void tick_init(void);
+uint16_t tick_now(void);
+// Whether at least ms milliseconds passed since the tick start
+bool tick_elapsed(uint16_t start, uint16_t ms);
+
+// Starts a sequence, its first step runs on the first poll
+void tick_seq_start(TickSeq *seq, TickStep step);
+// Runs the steps that are due. Returns true once the sequence is over.
+bool tick_seq_poll(TickSeq *seq);
+// Runs the whole sequence, waiting with busy loops. Does not need the timebase.
+void tick_seq_run(TickStep step);
+
+#endif /* TICK_H_ */
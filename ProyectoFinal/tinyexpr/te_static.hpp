@@ -0,0 +1,652 @@
+/*
+ * Compile-time front end for tinyexpr expressions known at build time, such
+ * as demo curves and calibration formulas. Needs C++14 (avr-g++ -std=gnu++14).
+ *
+ *   static const auto demo = TE_STATIC("sin(x)*exp(-x^2/8)");
+ *   double y = demo(1.5);
+ *   plot_add(&plot, demo.bind(&plot->real_x));
+ *
+ * The string is parsed by constexpr code during compilation into a table of
+ * nodes, and every node becomes a template instance that is inlined into
+ * straight-line code: no parsing, no tree walk and no heap at evaluation.
+ * bind() hands the same nodes to the runtime as a te_expr tree in static
+ * storage, filled in by the compiler, for the code that takes a tree.
+ * The grammar, precedence and builtins are those of te_compile with the
+ * default options (a^b^c = (a^b)^c), with x as the only variable. Constant
+ * arithmetic is folded and integer powers up to TE_STATIC_POWI_MAX become
+ * multiplications, as te_compile does. A string that does not parse fails
+ * the build. The runtime parser is still what handles keypad input.
+ */
+
+#ifndef TE_STATIC_HPP_
+#define TE_STATIC_HPP_
+
+#include <math.h>
+#include <stddef.h>
+#include <float.h>
+#include "tinyexpr.h"
+
+#define TE_STATIC(text) \
+    ([] { \
+        struct source { \
+            static constexpr ::te_static::Program<sizeof(text)> program() { \
+                return ::te_static::parse<sizeof(text)>(text); \
+            } \
+        }; \
+        return ::te_static::Expression<source>(); \
+    }())
+
+// Same bound as TE_POWI_MAX in tinyexpr.c
+#define TE_STATIC_POWI_MAX 16
+#define TE_STATIC_INLINE inline __attribute__((always_inline))
+
+namespace te_static {
+
+enum Op : unsigned char {
+    OP_CONST, OP_VAR, OP_NEG, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD,
+    OP_POW, OP_POWI, OP_COMMA, OP_CALL
+};
+
+// Builtins with an argument, in the alphabetical order of tinyexpr.c
+enum Fn : unsigned char {
+    FN_ABS, FN_ACOS, FN_ASIN, FN_ATAN, FN_ATAN2, FN_CEIL, FN_COS, FN_COSH,
+    FN_EXP, FN_FAC, FN_FLOOR, FN_LN, FN_LOG, FN_LOG10, FN_NCR, FN_NPR,
+    FN_POW, FN_SIN, FN_SINH, FN_SQRT, FN_TAN, FN_TANH, FN_COUNT
+};
+
+struct Builtin {
+    const char *name;
+    Fn fn;
+    unsigned char arity;
+};
+
+constexpr Builtin builtins[] = {
+    {"abs", FN_ABS, 1}, {"acos", FN_ACOS, 1}, {"asin", FN_ASIN, 1}, {"atan", FN_ATAN, 1},
+    {"atan2", FN_ATAN2, 2}, {"ceil", FN_CEIL, 1}, {"cos", FN_COS, 1}, {"cosh", FN_COSH, 1},
+    {"exp", FN_EXP, 1}, {"fac", FN_FAC, 1}, {"floor", FN_FLOOR, 1}, {"ln", FN_LN, 1},
+    {"log", FN_LOG, 1}, {"log10", FN_LOG10, 1}, {"ncr", FN_NCR, 2}, {"npr", FN_NPR, 2},
+    {"pow", FN_POW, 2}, {"sin", FN_SIN, 1}, {"sinh", FN_SINH, 1}, {"sqrt", FN_SQRT, 1},
+    {"tan", FN_TAN, 1}, {"tanh", FN_TANH, 1},
+};
+
+struct Node {
+    Op op = OP_CONST;
+    Fn fn = FN_COUNT;
+    int a = 0;              // Operands, as node indices
+    int b = 0;
+    double value = 0;
+};
+
+// Every node comes from at least one character of the text, so N nodes,
+// N being the size of the string, always fit.
+template<int N>
+struct Program {
+    Node nodes[N];
+    int count = 0;
+    int root = 0;
+    int error = 0;          // Position of a syntax error as in te_compile, 0 if none
+};
+
+template<int N>
+struct Parser {
+    const char *text;
+    int pos = 0;
+    Program<N> program;
+
+    constexpr explicit Parser(const char *t) : text(t) {}
+
+    constexpr void fail() {
+        if (!program.error) program.error = pos ? pos : 1;
+    }
+
+    constexpr void skip() {
+        while (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r') pos++;
+    }
+
+    constexpr bool accept(char c) {
+        skip();
+        if (text[pos] != c) return false;
+        pos++;
+        return true;
+    }
+
+    constexpr int add(Op op, int a, int b, double value) {
+        if (program.count == N) {
+            fail();
+            return 0;
+        }
+        Node &n = program.nodes[program.count];
+        n.op = op;
+        n.a = a;
+        n.b = b;
+        n.value = value;
+        return program.count++;
+    }
+
+    constexpr bool is_const(int i) const {
+        return program.nodes[i].op == OP_CONST;
+    }
+
+    // Folds like te_compile does for pure functions of constants, reusing a's node
+    constexpr int binary(Op op, int a, int b) {
+        Node &l = program.nodes[a];
+        if (is_const(a) && is_const(b)) {
+            double r = program.nodes[b].value;
+            switch (op) {
+                case OP_ADD: l.value = l.value + r; return a;
+                case OP_SUB: l.value = l.value - r; return a;
+                case OP_MUL: l.value = l.value * r; return a;
+                // A division by zero is not a constant expression, left to run time
+                case OP_DIV: if (r == 0) break; l.value = l.value / r; return a;
+                case OP_COMMA: l.value = r; return a;
+                default: break;
+            }
+        }
+        if (op == OP_POW && is_const(b)) {
+            double k = program.nodes[b].value;
+            if (k >= -TE_STATIC_POWI_MAX && k <= TE_STATIC_POWI_MAX && k == (int) k) op = OP_POWI;
+        }
+        return add(op, a, b, 0);
+    }
+
+    // Decimal literal as read by strtod. Correctly rounded for up to 15
+    // digits and exponents within the exact powers of ten, a couple of ulp
+    // off at worst for longer ones.
+    constexpr double number() {
+        unsigned long long mantissa = 0;
+        int digits = 0, scale = 0;
+        bool any = false;
+        char dropped = 0;       // First digit past the 19 kept, for rounding
+        for (; text[pos] >= '0' && text[pos] <= '9'; pos++, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (text[pos] - '0');
+                if (mantissa) digits++;
+            } else {
+                if (!dropped) dropped = text[pos];
+                scale++;
+            }
+        }
+        if (text[pos] == '.') {
+            for (pos++; text[pos] >= '0' && text[pos] <= '9'; pos++, any = true) {
+                if (digits < 19) {
+                    mantissa = mantissa * 10 + (text[pos] - '0');
+                    if (mantissa) digits++;
+                    scale--;
+                } else if (!dropped) {
+                    dropped = text[pos];
+                }
+            }
+        }
+        if (dropped >= '5') mantissa++;
+        if (!any) {
+            fail();
+            return 0;
+        }
+        if (text[pos] == 'e' || text[pos] == 'E') {
+            int p = pos + 1;
+            bool negative = text[p] == '-';
+            if (text[p] == '+' || text[p] == '-') p++;
+            if (text[p] >= '0' && text[p] <= '9') {
+                int exponent = 0;
+                for (; text[p] >= '0' && text[p] <= '9'; p++) {
+                    if (exponent < 10000) exponent = exponent * 10 + (text[p] - '0');
+                }
+                scale += negative ? -exponent : exponent;
+                pos = p;
+            }
+        }
+        if (!mantissa) return 0;
+        double value = (double) mantissa;
+        // Powers of ten past the range of double, where strtod gives 0 or HUGE_VAL
+        if (scale > DBL_MAX_10_EXP) return __builtin_huge_val();
+        if (scale < DBL_MIN_10_EXP) return 0;
+        double power = 1;
+        int s = scale < 0 ? -scale : scale;
+        for (int i = 0; i < s; i++) power *= 10;
+        return scale < 0 ? value / power : value * power;
+    }
+
+    constexpr bool name_is(int start, int len, const char *name) const {
+        for (int i = 0; i < len; i++) {
+            if (text[start + i] != name[i]) return false;
+        }
+        return name[len] == '\0';
+    }
+
+    constexpr int base() {
+        skip();
+        char c = text[pos];
+        if ((c >= '0' && c <= '9') || c == '.') {
+            double value = number();
+            return add(OP_CONST, 0, 0, value);
+        }
+        if (c == '(') {
+            pos++;
+            int ret = list();
+            if (!accept(')')) fail();
+            return ret;
+        }
+        if (c < 'a' || c > 'z') {
+            fail();
+            return add(OP_CONST, 0, 0, 0);
+        }
+        int start = pos;
+        while ((text[pos] >= 'a' && text[pos] <= 'z') || (text[pos] >= '0' && text[pos] <= '9') || text[pos] == '_') pos++;
+        int len = pos - start;
+        if (name_is(start, len, "x")) return add(OP_VAR, 0, 0, 0);
+        if (name_is(start, len, "pi") || name_is(start, len, "e")) {
+            // Functions without arguments, "pi" and "pi()" are the same
+            int ret = add(OP_CONST, 0, 0, len == 1 ? 2.71828182845904523536 : 3.14159265358979323846);
+            skip();
+            if (text[pos] == '(') {
+                pos++;
+                if (!accept(')')) fail();
+            }
+            return ret;
+        }
+        for (const Builtin &f : builtins) {
+            if (!name_is(start, len, f.name)) continue;
+            int ret = add(OP_CALL, 0, 0, 0);
+            program.nodes[ret].fn = f.fn;
+            if (f.arity == 1) {
+                // As in te_compile the argument binds like a power, sin x^2 = (sin x)^2
+                program.nodes[ret].a = power();
+            } else {
+                if (!accept('(')) fail();
+                program.nodes[ret].a = expr();
+                if (!accept(',')) fail();
+                program.nodes[ret].b = expr();
+                if (!accept(')')) fail();
+            }
+            return ret;
+        }
+        pos = start;
+        fail();
+        return add(OP_CONST, 0, 0, 0);
+    }
+
+    constexpr int power() {
+        bool negative = false;
+        for (;;) {
+            skip();
+            if (text[pos] == '-') negative = !negative;
+            else if (text[pos] != '+') break;
+            pos++;
+        }
+        int ret = base();
+        if (!negative) return ret;
+        if (is_const(ret)) {
+            program.nodes[ret].value = -program.nodes[ret].value;
+            return ret;
+        }
+        return add(OP_NEG, ret, 0, 0);
+    }
+
+    constexpr int factor() {
+        int ret = power();
+        while (accept('^')) {
+            int rhs = power();
+            ret = binary(OP_POW, ret, rhs);
+        }
+        return ret;
+    }
+
+    constexpr int term() {
+        int ret = factor();
+        for (;;) {
+            Op op = OP_CONST;
+            if (accept('*')) op = OP_MUL;
+            else if (accept('/')) op = OP_DIV;
+            else if (accept('%')) op = OP_MOD;
+            else return ret;
+            int rhs = factor();
+            ret = binary(op, ret, rhs);
+        }
+    }
+
+    constexpr int expr() {
+        int ret = term();
+        for (;;) {
+            Op op = OP_CONST;
+            if (accept('+')) op = OP_ADD;
+            else if (accept('-')) op = OP_SUB;
+            else return ret;
+            int rhs = term();
+            ret = binary(op, ret, rhs);
+        }
+    }
+
+    constexpr int list() {
+        int ret = expr();
+        while (accept(',')) {
+            int rhs = expr();
+            ret = binary(OP_COMMA, ret, rhs);
+        }
+        return ret;
+    }
+};
+
+template<int N>
+constexpr Program<N> parse(const char *text) {
+    Parser<N> parser(text);
+    parser.program.root = parser.list();
+    parser.skip();
+    if (text[parser.pos] != '\0') parser.fail();
+    return parser.program;
+}
+
+template<Fn F> struct Call;
+#define TE_STATIC_CALL1(FN, EXPR) \
+    template<> struct Call<FN> { static TE_STATIC_INLINE double apply(double a) { return EXPR; } }
+#define TE_STATIC_CALL2(FN, EXPR) \
+    template<> struct Call<FN> { static TE_STATIC_INLINE double apply(double a, double b) { return EXPR; } }
+TE_STATIC_CALL1(FN_ABS, fabs(a));
+TE_STATIC_CALL1(FN_ACOS, acos(a));
+TE_STATIC_CALL1(FN_ASIN, asin(a));
+TE_STATIC_CALL1(FN_ATAN, atan(a));
+TE_STATIC_CALL2(FN_ATAN2, atan2(a, b));
+TE_STATIC_CALL1(FN_CEIL, ceil(a));
+TE_STATIC_CALL1(FN_COS, cos(a));
+TE_STATIC_CALL1(FN_COSH, cosh(a));
+TE_STATIC_CALL1(FN_EXP, exp(a));
+TE_STATIC_CALL1(FN_FAC, te_fac(a));
+TE_STATIC_CALL1(FN_FLOOR, floor(a));
+TE_STATIC_CALL1(FN_LN, log(a));
+#ifdef TE_NAT_LOG
+TE_STATIC_CALL1(FN_LOG, log(a));
+#else
+TE_STATIC_CALL1(FN_LOG, log10(a));
+#endif
+TE_STATIC_CALL1(FN_LOG10, log10(a));
+TE_STATIC_CALL2(FN_NCR, te_ncr(a, b));
+TE_STATIC_CALL2(FN_NPR, te_npr(a, b));
+TE_STATIC_CALL2(FN_POW, pow(a, b));
+TE_STATIC_CALL1(FN_SIN, sin(a));
+TE_STATIC_CALL1(FN_SINH, sinh(a));
+TE_STATIC_CALL1(FN_SQRT, sqrt(a));
+TE_STATIC_CALL1(FN_TAN, tan(a));
+TE_STATIC_CALL1(FN_TANH, tanh(a));
+#undef TE_STATIC_CALL1
+#undef TE_STATIC_CALL2
+
+// Integer power by repeated squaring, in the order of powi in tinyexpr.c so
+// the results are the same
+template<unsigned K>
+struct PowU {
+    static TE_STATIC_INLINE double apply(double a, double ret) {
+        return PowU<K / 2>::apply(a * a, K & 1 ? ret * a : ret);
+    }
+};
+
+template<>
+struct PowU<0> {
+    static TE_STATIC_INLINE double apply(double, double ret) {
+        return ret;
+    }
+};
+
+template<class Src, int I> constexpr Node node_at() { return Src::program().nodes[I]; }
+
+template<class Src, int I, Op O = node_at<Src, I>().op>
+struct Eval;
+
+template<class Src, int I>
+struct Eval<Src, I, OP_CONST> {
+    static TE_STATIC_INLINE double apply(double) {
+        constexpr double value = node_at<Src, I>().value;
+        return value;
+    }
+};
+
+template<class Src, int I>
+struct Eval<Src, I, OP_VAR> {
+    static TE_STATIC_INLINE double apply(double x) { return x; }
+};
+
+#define TE_STATIC_A Eval<Src, node_at<Src, I>().a>::apply(x)
+#define TE_STATIC_B Eval<Src, node_at<Src, I>().b>::apply(x)
+#define TE_STATIC_EVAL(OP, EXPR) \
+    template<class Src, int I> \
+    struct Eval<Src, I, OP> { static TE_STATIC_INLINE double apply(double x) { return EXPR; } }
+TE_STATIC_EVAL(OP_NEG, -TE_STATIC_A);
+TE_STATIC_EVAL(OP_ADD, TE_STATIC_A + TE_STATIC_B);
+TE_STATIC_EVAL(OP_SUB, TE_STATIC_A - TE_STATIC_B);
+TE_STATIC_EVAL(OP_MUL, TE_STATIC_A * TE_STATIC_B);
+TE_STATIC_EVAL(OP_DIV, TE_STATIC_A / TE_STATIC_B);
+TE_STATIC_EVAL(OP_MOD, fmod(TE_STATIC_A, TE_STATIC_B));
+TE_STATIC_EVAL(OP_POW, pow(TE_STATIC_A, TE_STATIC_B));
+// The left side of a comma has no effects to keep
+TE_STATIC_EVAL(OP_COMMA, TE_STATIC_B);
+#undef TE_STATIC_EVAL
+
+template<class Src, int I>
+struct Eval<Src, I, OP_POWI> {
+    static TE_STATIC_INLINE double apply(double x) {
+        constexpr int k = (int) node_at<Src, node_at<Src, I>().b>().value;
+        double ret = PowU<(k < 0 ? -k : k)>::apply(TE_STATIC_A, 1);
+        return k < 0 ? 1 / ret : ret;
+    }
+};
+
+constexpr bool is_binary(Fn fn) {
+    return fn == FN_ATAN2 || fn == FN_NCR || fn == FN_NPR || fn == FN_POW;
+}
+
+template<class Src, int I, bool Binary = is_binary(node_at<Src, I>().fn)>
+struct EvalCall {
+    static TE_STATIC_INLINE double apply(double x) {
+        return Call<node_at<Src, I>().fn>::apply(TE_STATIC_A);
+    }
+};
+
+template<class Src, int I>
+struct EvalCall<Src, I, true> {
+    static TE_STATIC_INLINE double apply(double x) {
+        return Call<node_at<Src, I>().fn>::apply(TE_STATIC_A, TE_STATIC_B);
+    }
+};
+
+template<class Src, int I>
+struct Eval<Src, I, OP_CALL> : EvalCall<Src, I> {};
+#undef TE_STATIC_A
+#undef TE_STATIC_B
+
+typedef double (*Fun1)(double);
+typedef double (*Fun2)(double, double);
+
+// A node of a bound tree, laid out as a te_expr with two parameters so
+// te_eval, te_eval_complex and te_derive take it for a compiled one
+struct StaticNode {
+    int type;
+    union {
+        double value;
+        const double *bound;
+        Fun1 fun1;
+        Fun2 fun2;
+    };
+    const StaticNode *parameters[2];
+
+    constexpr StaticNode(int t, double v) : type(t), value(v), parameters{nullptr, nullptr} {}
+    constexpr StaticNode(int t, Fun1 f, const StaticNode *a) : type(t), fun1(f), parameters{a, nullptr} {}
+    constexpr StaticNode(int t, Fun2 f, const StaticNode *a, const StaticNode *b)
+        : type(t), fun2(f), parameters{a, b} {}
+};
+
+static_assert(offsetof(StaticNode, bound) == offsetof(te_expr, bound)
+              && offsetof(StaticNode, parameters) == offsetof(te_expr, parameters)
+              && sizeof(Fun1) == sizeof(const void *), "TE_STATIC: StaticNode does not match te_expr");
+
+// The functions te_compile binds, compared by address in tinyexpr.c.
+constexpr Fun1 fun1_of(Op op, Fn fn) {
+    if (op == OP_NEG) return te_negate;
+    switch (fn) {
+        case FN_ABS: return fabs;
+        case FN_ACOS: return acos;
+        case FN_ASIN: return asin;
+        case FN_ATAN: return atan;
+        case FN_CEIL: return ceil;
+        case FN_COS: return cos;
+        case FN_COSH: return cosh;
+        case FN_EXP: return exp;
+        case FN_FAC: return te_fac;
+        case FN_FLOOR: return floor;
+        case FN_LN: return log;
+#ifdef TE_NAT_LOG
+        case FN_LOG: return log;
+#else
+        case FN_LOG: return log10;
+#endif
+        case FN_LOG10: return log10;
+        case FN_SIN: return sin;
+        case FN_SINH: return sinh;
+        case FN_SQRT: return sqrt;
+        case FN_TAN: return tan;
+        case FN_TANH: return tanh;
+        default: return nullptr;
+    }
+}
+
+constexpr Fun2 fun2_of(Op op, Fn fn) {
+    switch (op) {
+        case OP_ADD: return te_add;
+        case OP_SUB: return te_sub;
+        case OP_MUL: return te_mul;
+        case OP_DIV: return te_divide;
+        case OP_MOD: return fmod;
+        case OP_POW: case OP_POWI: return pow;
+        case OP_COMMA: return te_comma;
+        default: break;
+    }
+    switch (fn) {
+        case FN_ATAN2: return atan2;
+        case FN_NCR: return te_ncr;
+        case FN_NPR: return te_npr;
+        case FN_POW: return pow;
+        default: return nullptr;
+    }
+}
+
+template<int N>
+constexpr int arity_of(const Program<N> &p, int i) {
+    const Node &n = p.nodes[i];
+    if (n.op == OP_CONST || n.op == OP_VAR) return 0;
+    if (n.op == OP_NEG || (n.op == OP_CALL && !is_binary(n.fn))) return 1;
+    return 2;
+}
+
+// The opcode specialize() in tinyexpr.c gives the node
+template<int N>
+constexpr int opcode_of(const Program<N> &p, int i) {
+    const Node &n = p.nodes[i];
+    switch (n.op) {
+        case OP_NEG: return TE_OP_NEG;
+        case OP_ADD: return TE_OP_ADD;
+        case OP_SUB: return TE_OP_SUB;
+        case OP_MUL: return TE_OP_MUL;
+        case OP_DIV: return TE_OP_DIV;
+        case OP_POW: return TE_OP_POW;
+        case OP_POWI: return TE_OP_POWI;
+        case OP_CALL: break;
+        default: return TE_OP_NONE;
+    }
+    if (n.fn == FN_SIN) return TE_OP_SIN;
+    if (n.fn == FN_COS) return TE_OP_COS;
+    if (n.fn != FN_POW) return TE_OP_NONE;
+    const Node &k = p.nodes[n.b];
+    return k.op == OP_CONST && k.value >= -TE_STATIC_POWI_MAX && k.value <= TE_STATIC_POWI_MAX
+        && k.value == (int) k.value ? TE_OP_POWI : TE_OP_POW;
+}
+
+// Whether the node gets TE_FLAG_REAL from specialize(): its arguments are
+// real and it is not one of the builtins with complex values for real ones
+template<int N>
+constexpr bool is_real(const Program<N> &p, int i) {
+    const Node &n = p.nodes[i];
+    int arity = arity_of(p, i);
+    if (!arity) return true;
+    if (!is_real(p, n.a) || (arity == 2 && !is_real(p, n.b))) return false;
+    if (opcode_of(p, i) == TE_OP_POW) return false;
+    return n.op != OP_CALL || !(n.fn == FN_SQRT || n.fn == FN_LN || n.fn == FN_LOG || n.fn == FN_LOG10
+                                || n.fn == FN_ASIN || n.fn == FN_ACOS);
+}
+
+template<int N>
+constexpr int type_of(const Program<N> &p, int i) {
+    int arity = arity_of(p, i);
+    int type = p.nodes[i].op == OP_CONST ? TE_CONSTANT : TE_VARIABLE;
+    if (arity) {
+        type = (arity == 1 ? TE_FUNCTION1 : TE_FUNCTION2) | TE_FLAG_PURE | TE_OPCODE(opcode_of(p, i))
+            | (is_real(p, i) ? TE_FLAG_REAL : 0);
+    }
+    return i == p.root ? type | TE_FLAG_STATIC : type;
+}
+
+template<class Src, int I>
+constexpr StaticNode make_node(const StaticNode *nodes) {
+    constexpr Node n = node_at<Src, I>();
+    constexpr int type = type_of(Src::program(), I);
+    return arity_of(Src::program(), I) == 0 ? StaticNode(type, n.value)
+        : arity_of(Src::program(), I) == 1 ? StaticNode(type, fun1_of(n.op, n.fn), nodes + n.a)
+        : StaticNode(type, fun2_of(n.op, n.fn), nodes + n.a, nodes + n.b);
+}
+
+template<int... I> struct Indices {};
+template<int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template<int... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+template<class Src, int I, bool Var = node_at<Src, I>().op == OP_VAR>
+struct BindVar {
+    static TE_STATIC_INLINE void apply(StaticNode *, const double *) {}
+};
+
+template<class Src, int I>
+struct BindVar<Src, I, true> {
+    static TE_STATIC_INLINE void apply(StaticNode *nodes, const double *x) { nodes[I].bound = x; }
+};
+
+// The nodes of an expression as a te_expr tree, constant-initialized so
+// nothing is built at run time
+template<class Src, class Seq = typename MakeIndices<Src::program().count>::type>
+struct Tree;
+
+template<class Src, int... I>
+struct Tree<Src, Indices<I...>> {
+    static StaticNode nodes[sizeof...(I)];
+
+    static te_expr *bind(const double *x) {
+        constexpr int root = Src::program().root;
+        int unused[] = {(BindVar<Src, I>::apply(nodes, x), 0)...};
+        (void) unused;
+        return reinterpret_cast<te_expr *>(&nodes[root]);
+    }
+};
+
+template<class Src, int... I>
+StaticNode Tree<Src, Indices<I...>>::nodes[sizeof...(I)] = {make_node<Src, I>(nodes)...};
+
+template<class Src>
+struct Expression {
+    static_assert(Src::program().error == 0, "TE_STATIC: syntax error or unknown name in the expression");
+
+    static double eval(double x) {
+        return Eval<Src, Src::program().root>::apply(x);
+    }
+
+    double operator()(double x) const {
+        return eval(x);
+    }
+
+    // The expression as a te_expr tree of the variable at x, for plot_add,
+    // the solvers and te_derive. The tree is static and te_free leaves it
+    // alone. There is one per expression, binding it again moves every
+    // earlier result to the new variable.
+    te_expr *bind(const double *x) const {
+        return Tree<Src>::bind(x);
+    }
+};
+
+} // namespace te_static
+
+#undef TE_STATIC_INLINE
+
+#endif /* TE_STATIC_HPP_ */
@@ -34,12 +34,31 @@ For log = base 10 log do nothing
 For log = natural log uncomment the next line. */
 /* #define TE_NAT_LOG */
 
+/* Inline kernels
+Hot operators and functions run in a switch inside te_eval. To call every
+function through its pointer instead uncomment the next line. */
+/* #define TE_NO_INLINE_KERNELS */
+
+/* Frame evaluation
+te_eval_frame is only built for hosts. The firmware evaluates one expression
+at a time and has no flash to spare for a second evaluator. */
+
+/* Complex evaluation
+te_eval_complex is built with the complex forms of the builtins, calc mode
+shows the imaginary part of its results. To leave those out of the flash
+uncomment the next line, te_eval_complex then gives te_eval's result with a
+zero imaginary part. The batch form over arrays, te_eval_complex_batch, is
+only built for hosts. */
+/* #define TE_NO_COMPLEX */
+
 #include "tinyexpr.h"
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <limits.h>
+#include <stdint.h>
 
 #ifndef NAN
 #define NAN (0.0/0.0)
@@ -58,9 +77,6 @@ enum {
 };
 
 
-enum {TE_CONSTANT = 1};
-
-
 typedef struct state {
     const char *start;
     const char *next;
@@ -74,17 +90,27 @@ typedef struct state {
 
 
 #define TYPE_MASK(TYPE) ((TYPE)&0x0000001F)
+#define OPCODE(TYPE) (((TYPE) >> 8) & 0x7F)
 
 #define IS_PURE(TYPE) (((TYPE) & TE_FLAG_PURE) != 0)
+#define IS_REAL(TYPE) (((TYPE) & TE_FLAG_REAL) != 0)
 #define IS_FUNCTION(TYPE) (((TYPE) & TE_FUNCTION0) != 0)
 #define IS_CLOSURE(TYPE) (((TYPE) & TE_CLOSURE0) != 0)
 #define ARITY(TYPE) ( ((TYPE) & (TE_FUNCTION0 | TE_CLOSURE0)) ? ((TYPE) & 0x00000007) : 0 )
 #define NEW_EXPR(type, ...) new_expr((type), (const te_expr*[]){__VA_ARGS__})
 
+/* Bytes of a node, with its parameters and the context of a closure. */
+static int node_size(const int type) {
+    const int psize = sizeof(void*) * ARITY(type);
+    const int needed = (sizeof(te_expr) - sizeof(void*)) + psize + (IS_CLOSURE(type) ? sizeof(void*) : 0);
+    /* Leaves need no parameter slot, but are written through a whole te_expr. */
+    return needed < (int)sizeof(te_expr) ? (int)sizeof(te_expr) : needed;
+}
+
 static te_expr *new_expr(const int type, const te_expr *parameters[]) {
     const int arity = ARITY(type);
     const int psize = sizeof(void*) * arity;
-    const int size = (sizeof(te_expr) - sizeof(void*)) + psize + (IS_CLOSURE(type) ? sizeof(void*) : 0);
+    const int size = node_size(type);
     te_expr *ret = malloc(size);
     memset(ret, 0, size);
     if (arity && parameters) {
@@ -111,15 +137,55 @@ void te_free_parameters(te_expr *n) {
 
 
 void te_free(te_expr *n) {
-    if (!n) return;
+    if (!n || (n->type & TE_FLAG_STATIC)) return;
     te_free_parameters(n);
     free(n);
 }
 
 
+/* te_copy lays the nodes out back to back, each one aligned like a te_expr. */
+#define NODE_ALIGN offsetof(struct {char c; te_expr n;}, n)
+#define NODE_STRIDE(TYPE) ((node_size(TYPE) + NODE_ALIGN - 1) / NODE_ALIGN * NODE_ALIGN)
+
+int te_size(const te_expr *n) {
+    const int arity = ARITY(n->type);
+    int size = NODE_STRIDE(n->type);
+    int i;
+    for (i = 0; i < arity; ++i) {
+        size += te_size(n->parameters[i]);
+    }
+    return size;
+}
+
+static te_expr *copy_to(const te_expr *n, char **next) {
+    const int type = n->type & ~TE_FLAG_STATIC;
+    const int arity = ARITY(type);
+    te_expr *ret = (te_expr*)*next;
+    int i;
+    /* Copies the closure context along with the node */
+    memcpy(ret, n, node_size(type));
+    ret->type = type;
+    *next += NODE_STRIDE(type);
+    for (i = 0; i < arity; ++i) {
+        ret->parameters[i] = copy_to(n->parameters[i], next);
+    }
+    return ret;
+}
+
+
+te_expr *te_copy(const te_expr *n, void *arena, int size) {
+    char *next = arena;
+    te_expr *ret;
+    if (!n || te_size(n) > size) return 0;
+    ret = copy_to(n, &next);
+    ret->type |= TE_FLAG_STATIC;
+    return ret;
+}
+
+
 static double pi(void) {return 3.14159265358979323846;}
 static double e(void) {return 2.71828182845904523536;}
-static double fac(double a) {/* simplest version of fac */
+double te_fac(double a) {/* simplest version of fac */
     if (a < 0.0)
         return NAN;
     if (a > UINT_MAX)
@@ -133,7 +199,7 @@ static double fac(double a) {/* simplest version of fac */
     }
     return (double)result;
 }
-static double ncr(double n, double r) {
+double te_ncr(double n, double r) {
     if (n < 0.0 || r < 0.0 || n < r) return NAN;
     if (n > UINT_MAX || r > UINT_MAX) return INFINITY;
     unsigned long int un = (unsigned int)(n), ur = (unsigned int)(r), i;
@@ -147,11 +213,11 @@ static double ncr(double n, double r) {
     }
     return result;
 }
-static double npr(double n, double r) {return ncr(n, r) * fac(r);}
+double te_npr(double n, double r) {return te_ncr(n, r) * te_fac(r);}
 
 static const te_variable functions[] = {
     /* must be in alphabetical order */
-    {"abs", abs,     TE_FUNCTION1 | TE_FLAG_PURE, 0},
+    {"abs", fabs,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"acos", acos,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"asin", asin,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"atan", atan,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
@@ -161,7 +227,7 @@ static const te_variable functions[] = {
     {"cosh", cosh,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"e", e,          TE_FUNCTION0 | TE_FLAG_PURE, 0},
     {"exp", exp,      TE_FUNCTION1 | TE_FLAG_PURE, 0},
-    {"fac", fac,      TE_FUNCTION1 | TE_FLAG_PURE, 0},
+    {"fac", te_fac,   TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"floor", floor,  TE_FUNCTION1 | TE_FLAG_PURE, 0},
     {"ln", log,       TE_FUNCTION1 | TE_FLAG_PURE, 0},
 #ifdef TE_NAT_LOG
@@ -170,8 +236,8 @@ static const te_variable functions[] = {
     {"log", log10,    TE_FUNCTION1 | TE_FLAG_PURE, 0},
 #endif
     {"log10", log10,  TE_FUNCTION1 | TE_FLAG_PURE, 0},
-    {"ncr", ncr,      TE_FUNCTION2 | TE_FLAG_PURE, 0},
-    {"npr", npr,      TE_FUNCTION2 | TE_FLAG_PURE, 0},
+    {"ncr", te_ncr,   TE_FUNCTION2 | TE_FLAG_PURE, 0},
+    {"npr", te_npr,   TE_FUNCTION2 | TE_FLAG_PURE, 0},
     {"pi", pi,        TE_FUNCTION0 | TE_FLAG_PURE, 0},
     {"pow", pow,      TE_FUNCTION2 | TE_FLAG_PURE, 0},
     {"sin", sin,      TE_FUNCTION1 | TE_FLAG_PURE, 0},
@@ -203,6 +269,12 @@ static const te_variable *find_builtin(const char *name, int len) {
     return 0;
 }
 
+static te_resolver resolver = 0;
+
+void te_set_resolver(te_resolver r) {
+    resolver = r;
+}
+
 static const te_variable *find_lookup(const state *s, const char *name, int len) {
     int iters;
     const te_variable *var;
@@ -218,12 +290,12 @@ static const te_variable *find_lookup(const state *s, const char *name, int len)
 
 
 
-static double add(double a, double b) {return a + b;}
-static double sub(double a, double b) {return a - b;}
-static double mul(double a, double b) {return a * b;}
-static double divide(double a, double b) {return a / b;}
-static double negate(double a) {return -a;}
-static double comma(double a, double b) {(void)a; return b;}
+double te_add(double a, double b) {return a + b;}
+double te_sub(double a, double b) {return a - b;}
+double te_mul(double a, double b) {return a * b;}
+double te_divide(double a, double b) {return a / b;}
+double te_negate(double a) {return -a;}
+double te_comma(double a, double b) {(void)a; return b;}
 
 
 void next_token(state *s) {
@@ -248,6 +320,7 @@ void next_token(state *s) {
                 while ((s->next[0] >= 'a' && s->next[0] <= 'z') || (s->next[0] >= '0' && s->next[0] <= '9') || (s->next[0] == '_')) s->next++;
 
                 const te_variable *var = find_lookup(s, start, s->next - start);
+                if (!var && resolver) var = resolver(start, s->next - start);
                 if (!var) var = find_builtin(start, s->next - start);
 
                 if (!var) {
@@ -275,10 +348,10 @@ void next_token(state *s) {
             } else {
                 /* Look for an operator or special character. */
                 switch (s->next++[0]) {
-                    case '+': s->type = TOK_INFIX; s->function = add; break;
-                    case '-': s->type = TOK_INFIX; s->function = sub; break;
-                    case '*': s->type = TOK_INFIX; s->function = mul; break;
-                    case '/': s->type = TOK_INFIX; s->function = divide; break;
+                    case '+': s->type = TOK_INFIX; s->function = te_add; break;
+                    case '-': s->type = TOK_INFIX; s->function = te_sub; break;
+                    case '*': s->type = TOK_INFIX; s->function = te_mul; break;
+                    case '/': s->type = TOK_INFIX; s->function = te_divide; break;
                     case '^': s->type = TOK_INFIX; s->function = pow; break;
                     case '%': s->type = TOK_INFIX; s->function = fmod; break;
                     case '(': s->type = TOK_OPEN; break;
@@ -395,8 +468,8 @@ static te_expr *base(state *s) {
 static te_expr *power(state *s) {
     /* <power>     =    {("-" | "+")} <base> */
     int sign = 1;
-    while (s->type == TOK_INFIX && (s->function == add || s->function == sub)) {
-        if (s->function == sub) sign = -sign;
+    while (s->type == TOK_INFIX && (s->function == te_add || s->function == te_sub)) {
+        if (s->function == te_sub) sign = -sign;
         next_token(s);
     }
 
@@ -406,7 +479,7 @@ static te_expr *power(state *s) {
         ret = base(s);
     } else {
         ret = NEW_EXPR(TE_FUNCTION1 | TE_FLAG_PURE, base(s));
-        ret->function = negate;
+        ret->function = te_negate;
     }
 
     return ret;
@@ -420,7 +493,7 @@ static te_expr *factor(state *s) {
     int neg = 0;
     te_expr *insertion = 0;
 
-    if (ret->type == (TE_FUNCTION1 | TE_FLAG_PURE) && ret->function == negate) {
+    if (ret->type == (TE_FUNCTION1 | TE_FLAG_PURE) && ret->function == te_negate) {
         te_expr *se = ret->parameters[0];
         free(ret);
         ret = se;
@@ -446,7 +519,7 @@ static te_expr *factor(state *s) {
 
     if (neg) {
         ret = NEW_EXPR(TE_FUNCTION1 | TE_FLAG_PURE, ret);
-        ret->function = negate;
+        ret->function = te_negate;
     }
 
     return ret;
@@ -473,7 +546,7 @@ static te_expr *term(state *s) {
     /* <term>      =    <factor> {("*" | "/" | "%") <factor>} */
     te_expr *ret = factor(s);
 
-    while (s->type == TOK_INFIX && (s->function == mul || s->function == divide || s->function == fmod)) {
+    while (s->type == TOK_INFIX && (s->function == te_mul || s->function == te_divide || s->function == fmod)) {
         te_fun2 t = s->function;
         next_token(s);
         ret = NEW_EXPR(TE_FUNCTION2 | TE_FLAG_PURE, ret, factor(s));
@@ -488,7 +561,7 @@ static te_expr *expr(state *s) {
     /* <expr>      =    <term> {("+" | "-") <term>} */
     te_expr *ret = term(s);
 
-    while (s->type == TOK_INFIX && (s->function == add || s->function == sub)) {
+    while (s->type == TOK_INFIX && (s->function == te_add || s->function == te_sub)) {
         te_fun2 t = s->function;
         next_token(s);
         ret = NEW_EXPR(TE_FUNCTION2 | TE_FLAG_PURE, ret, term(s));
@@ -506,60 +579,157 @@ static te_expr *list(state *s) {
     while (s->type == TOK_SEP) {
         next_token(s);
         ret = NEW_EXPR(TE_FUNCTION2 | TE_FLAG_PURE, ret, expr(s));
-        ret->function = comma;
+        ret->function = te_comma;
     }
 
     return ret;
 }
 
 
+#ifdef __AVR__
+/* No threads to share a tree with, te_eval passes no frame */
+typedef struct te_frame te_frame;
+#endif
+
 #define TE_FUN(...) ((double(*)(__VA_ARGS__))n->function)
-#define M(e) te_eval(n->parameters[e])
+#define M(e) eval(n->parameters[e], frame)
+
+/* Largest exponent magnitude TE_OP_POWI handles by repeated squaring */
+#define TE_POWI_MAX 16
+
+static double powi(double a, int k) {
+    unsigned int u = k < 0 ? -k : k;
+    double ret = 1;
+    while (u) {
+        if (u & 1) ret *= a;
+        a *= a;
+        u >>= 1;
+    }
+    return k < 0 ? 1 / ret : ret;
+}
 
 
-double te_eval(const te_expr *n) {
+/* n applied to the values of its arguments, through its function pointer. */
+/* Shared by every evaluator so they all give te_eval's results. */
+static double apply(const te_expr *n, const double *x) {
+#ifndef TE_NO_INLINE_KERNELS
+    /* The one kernel that does not round like its function */
+    if (!IS_CLOSURE(n->type) && OPCODE(n->type) == TE_OP_POWI) {
+        return powi(x[0], (int)((const te_expr*)n->parameters[1])->value);
+    }
+#endif
+    if (IS_CLOSURE(n->type)) {
+        void *c = n->parameters[ARITY(n->type)];
+        switch(ARITY(n->type)) {
+            case 0: return TE_FUN(void*)(c);
+            case 1: return TE_FUN(void*, double)(c, x[0]);
+            case 2: return TE_FUN(void*, double, double)(c, x[0], x[1]);
+            case 3: return TE_FUN(void*, double, double, double)(c, x[0], x[1], x[2]);
+            case 4: return TE_FUN(void*, double, double, double, double)(c, x[0], x[1], x[2], x[3]);
+            case 5: return TE_FUN(void*, double, double, double, double, double)(c, x[0], x[1], x[2], x[3], x[4]);
+            case 6: return TE_FUN(void*, double, double, double, double, double, double)(c, x[0], x[1], x[2], x[3], x[4], x[5]);
+            case 7: return TE_FUN(void*, double, double, double, double, double, double, double)(c, x[0], x[1], x[2], x[3], x[4], x[5], x[6]);
+            default: return NAN;
+        }
+    }
+    switch(ARITY(n->type)) {
+        case 0: return TE_FUN(void)();
+        case 1: return TE_FUN(double)(x[0]);
+        case 2: return TE_FUN(double, double)(x[0], x[1]);
+        case 3: return TE_FUN(double, double, double)(x[0], x[1], x[2]);
+        case 4: return TE_FUN(double, double, double, double)(x[0], x[1], x[2], x[3]);
+        case 5: return TE_FUN(double, double, double, double, double)(x[0], x[1], x[2], x[3], x[4]);
+        case 6: return TE_FUN(double, double, double, double, double, double)(x[0], x[1], x[2], x[3], x[4], x[5]);
+        case 7: return TE_FUN(double, double, double, double, double, double, double)(x[0], x[1], x[2], x[3], x[4], x[5], x[6]);
+        default: return NAN;
+    }
+}
+
+
+static double eval(const te_expr *n, const te_frame *frame);
+
+/* Evaluates the arguments and applies n. Kept out of eval, whose frame */
+/* stays small for the kernels. */
+static __attribute__((noinline)) double call(const te_expr *n, const te_frame *frame) {
+    const int arity = ARITY(n->type);
+    double x[arity ? arity : 1];
+    int i;
+    for (i = 0; i < arity; ++i) x[i] = M(i);
+    return apply(n, x);
+}
+
+static double eval(const te_expr *n, const te_frame *frame) {
     if (!n) return NAN;
 
     switch(TYPE_MASK(n->type)) {
         case TE_CONSTANT: return n->value;
-        case TE_VARIABLE: return *n->bound;
+        case TE_VARIABLE:
+#ifndef __AVR__
+            if (frame) {
+                /* Compared as integers, the slots and the bound address may be unrelated objects. */
+                uintptr_t slot = ((uintptr_t)n->bound - (uintptr_t)frame->slots) / sizeof(double);
+                if ((uintptr_t)n->bound >= (uintptr_t)frame->slots && slot < (uintptr_t)frame->count) {
+                    return frame->values[slot];
+                }
+            }
+#endif
+            return *n->bound;
 
         case TE_FUNCTION0: case TE_FUNCTION1: case TE_FUNCTION2: case TE_FUNCTION3:
         case TE_FUNCTION4: case TE_FUNCTION5: case TE_FUNCTION6: case TE_FUNCTION7:
-            switch(ARITY(n->type)) {
-                case 0: return TE_FUN(void)();
-                case 1: return TE_FUN(double)(M(0));
-                case 2: return TE_FUN(double, double)(M(0), M(1));
-                case 3: return TE_FUN(double, double, double)(M(0), M(1), M(2));
-                case 4: return TE_FUN(double, double, double, double)(M(0), M(1), M(2), M(3));
-                case 5: return TE_FUN(double, double, double, double, double)(M(0), M(1), M(2), M(3), M(4));
-                case 6: return TE_FUN(double, double, double, double, double, double)(M(0), M(1), M(2), M(3), M(4), M(5));
-                case 7: return TE_FUN(double, double, double, double, double, double, double)(M(0), M(1), M(2), M(3), M(4), M(5), M(6));
-                default: return NAN;
+#ifndef TE_NO_INLINE_KERNELS
+            switch(OPCODE(n->type)) {
+                case TE_OP_ADD: return M(0) + M(1);
+                case TE_OP_SUB: return M(0) - M(1);
+                case TE_OP_MUL: return M(0) * M(1);
+                case TE_OP_DIV: return M(0) / M(1);
+                case TE_OP_NEG: return -M(0);
+                case TE_OP_POW: return pow(M(0), M(1));
+                case TE_OP_POWI: return powi(M(0), (int)((const te_expr*)n->parameters[1])->value);
+                case TE_OP_SIN: return sin(M(0));
+                case TE_OP_COS: return cos(M(0));
             }
-
+#endif
+            /* Falls through. */
         case TE_CLOSURE0: case TE_CLOSURE1: case TE_CLOSURE2: case TE_CLOSURE3:
         case TE_CLOSURE4: case TE_CLOSURE5: case TE_CLOSURE6: case TE_CLOSURE7:
-            switch(ARITY(n->type)) {
-                case 0: return TE_FUN(void*)(n->parameters[0]);
-                case 1: return TE_FUN(void*, double)(n->parameters[1], M(0));
-                case 2: return TE_FUN(void*, double, double)(n->parameters[2], M(0), M(1));
-                case 3: return TE_FUN(void*, double, double, double)(n->parameters[3], M(0), M(1), M(2));
-                case 4: return TE_FUN(void*, double, double, double, double)(n->parameters[4], M(0), M(1), M(2), M(3));
-                case 5: return TE_FUN(void*, double, double, double, double, double)(n->parameters[5], M(0), M(1), M(2), M(3), M(4));
-                case 6: return TE_FUN(void*, double, double, double, double, double, double)(n->parameters[6], M(0), M(1), M(2), M(3), M(4), M(5));
-                case 7: return TE_FUN(void*, double, double, double, double, double, double, double)(n->parameters[7], M(0), M(1), M(2), M(3), M(4), M(5), M(6));
-                default: return NAN;
-            }
+            return call(n, frame);
 
         default: return NAN;
     }
 
 }
 
+double te_eval(const te_expr *n) {
+    return eval(n, 0);
+}
+
+#ifndef __AVR__
+double te_eval_frame(const te_expr *n, const te_frame *frame) {
+    return eval(n, frame);
+}
+#endif
+
 #undef TE_FUN
 #undef M
 
+static int leaves_reals(const te_expr *n) {
+    /* Builtins with complex values for some real arguments, e.g. sqrt(-1) */
+    const void *f = n->function;
+    if (IS_CLOSURE(n->type)) return 0;
+    return f == sqrt || f == log || f == log10 || f == asin || f == acos
+        || (f == pow && OPCODE(n->type) != TE_OP_POWI);
+}
+
+static int in_real_domain(const te_expr *n, const double *x) {
+    const void *f = n->function;
+    if (!leaves_reals(n)) return 1;
+    if (f == sqrt || f == log || f == log10) return x[0] >= 0;
+    if (f == asin || f == acos) return x[0] >= -1 && x[0] <= 1;
+    /* pow: negative bases only to integer powers */
+    return x[0] >= 0 || x[1] == floor(x[1]);
+}
+
 static void optimize(te_expr *n) {
     /* Evaluates as much as possible. */
     if (n->type == TE_CONSTANT) return;
@@ -570,13 +740,17 @@ static void optimize(te_expr *n) {
         const int arity = ARITY(n->type);
         int known = 1;
         int i;
+        double args[7];
         for (i = 0; i < arity; ++i) {
             optimize(n->parameters[i]);
             if (((te_expr*)(n->parameters[i]))->type != TE_CONSTANT) {
                 known = 0;
+            } else {
+                args[i] = ((te_expr*)(n->parameters[i]))->value;
             }
         }
-        if (known) {
+        /* Complex values such as sqrt(-1) are left for te_eval_complex. */
+        if (known && in_real_domain(n, args)) {
             const double value = te_eval(n);
             te_free_parameters(n);
             n->type = TE_CONSTANT;
@@ -586,6 +760,42 @@ static void optimize(te_expr *n) {
 }
 
 
+static const struct {const void *function; int op;} kernels[] = {
+    {te_add, TE_OP_ADD}, {te_sub, TE_OP_SUB}, {te_mul, TE_OP_MUL}, {te_divide, TE_OP_DIV},
+    {te_negate, TE_OP_NEG}, {pow, TE_OP_POW}, {sin, TE_OP_SIN}, {cos, TE_OP_COS}
+};
+
+static void specialize(te_expr *n) {
+    /* Tags the functions that have an inline kernel with its opcode, and the */
+    /* ones that stay real with TE_FLAG_REAL. */
+    int i, real = 1;
+    if (!IS_FUNCTION(n->type) && !IS_CLOSURE(n->type)) return;
+    for (i = 0; i < ARITY(n->type); ++i) {
+        const te_expr *p = n->parameters[i];
+        specialize(n->parameters[i]);
+        if ((IS_FUNCTION(p->type) || IS_CLOSURE(p->type)) && !IS_REAL(p->type)) real = 0;
+    }
+
+    if (!IS_CLOSURE(n->type) && !OPCODE(n->type)) {
+        for (i = 0; i < (int)(sizeof(kernels) / sizeof(kernels[0])); ++i) {
+            if (n->function == kernels[i].function) {
+                n->type |= TE_OPCODE(kernels[i].op);
+                break;
+            }
+        }
+    }
+    if (!IS_CLOSURE(n->type) && OPCODE(n->type) == TE_OP_POW) {
+        const te_expr *k = n->parameters[1];
+        if (k->type == TE_CONSTANT && k->value >= -TE_POWI_MAX && k->value <= TE_POWI_MAX
+                && k->value == (int)k->value) {
+            n->type = (n->type & 0xFF) | TE_OPCODE(TE_OP_POWI);
+        }
+    }
+    /* Functions without a complex form count as real, they refuse complex arguments. */
+    if (real && !leaves_reals(n)) n->type |= TE_FLAG_REAL;
+}
+
+
 te_expr *te_compile(const char *expression, const te_variable *variables, int var_count, int *error) {
     state s;
     s.start = s.next = expression;
@@ -604,12 +814,425 @@ te_expr *te_compile(const char *expression, const te_variable *variables, int va
         return 0;
     } else {
         optimize(root);
+        specialize(root);
         if (error) *error = 0;
         return root;
     }
 }
 
 
+/* Symbolic differentiation. The result is a fresh tree, the input is only read. */
+
+static te_expr *d_const(double value) {
+    te_expr *ret = new_expr(TE_CONSTANT, 0);
+    ret->value = value;
+    return ret;
+}
+
+static int is_const(const te_expr *n, double value) {
+    return n->type == TE_CONSTANT && n->value == value;
+}
+
+static te_expr *d_fun1(const void *function, te_expr *a) {
+    te_expr *ret = NEW_EXPR(TE_FUNCTION1 | TE_FLAG_PURE, a);
+    ret->function = function;
+    return ret;
+}
+
+static te_expr *d_fun2(const void *function, te_expr *a, te_expr *b) {
+    te_expr *ret = NEW_EXPR(TE_FUNCTION2 | TE_FLAG_PURE, a, b);
+    ret->function = function;
+    return ret;
+}
+
+/* Node builders that drop the zeros and ones the chain rule produces, so
+   the derivative stays about as small as the function. */
+static te_expr *d_neg(te_expr *a) {
+    if (a->type == TE_CONSTANT) {
+        a->value = -a->value;
+        return a;
+    }
+    return d_fun1(te_negate, a);
+}
+
+static te_expr *d_add(te_expr *a, te_expr *b) {
+    if (is_const(a, 0.0)) {te_free(a); return b;}
+    if (is_const(b, 0.0)) {te_free(b); return a;}
+    return d_fun2(te_add, a, b);
+}
+
+static te_expr *d_sub(te_expr *a, te_expr *b) {
+    if (is_const(b, 0.0)) {te_free(b); return a;}
+    if (is_const(a, 0.0)) {te_free(a); return d_neg(b);}
+    return d_fun2(te_sub, a, b);
+}
+
+static te_expr *d_mul(te_expr *a, te_expr *b) {
+    if (is_const(a, 0.0) || is_const(b, 0.0)) {te_free(a); te_free(b); return d_const(0.0);}
+    if (is_const(a, 1.0)) {te_free(a); return b;}
+    if (is_const(b, 1.0)) {te_free(b); return a;}
+    return d_fun2(te_mul, a, b);
+}
+
+static te_expr *d_div(te_expr *a, te_expr *b) {
+    if (is_const(a, 0.0)) {te_free(a); te_free(b); return d_const(0.0);}
+    if (is_const(b, 1.0)) {te_free(b); return a;}
+    return d_fun2(te_divide, a, b);
+}
+
+static te_expr *d_copy(const te_expr *n) {
+    /* Copies of a static tree are freed like any other */
+    const int type = n->type & ~TE_FLAG_STATIC;
+    const int arity = ARITY(type);
+    te_expr *ret = new_expr(type, 0);
+    int i;
+    if (type == TE_CONSTANT) ret->value = n->value;
+    else if (type == TE_VARIABLE) ret->bound = n->bound;
+    else ret->function = n->function;
+    for (i = 0; i < arity; ++i) {
+        ret->parameters[i] = d_copy(n->parameters[i]);
+    }
+    if (IS_CLOSURE(type)) ret->parameters[arity] = n->parameters[arity];
+    return ret;
+}
+
+static te_expr *derive(const te_expr *n, const double *var) {
+    const te_expr *u, *v;
+    te_expr *du, *dv;
+
+    switch (TYPE_MASK(n->type)) {
+        case TE_CONSTANT: return d_const(0.0);
+        case TE_VARIABLE: return d_const(n->bound == var ? 1.0 : 0.0);
+        case TE_FUNCTION0: return d_const(0.0);
+        case TE_FUNCTION1: case TE_FUNCTION2: break;
+        /* Closures and wider functions are opaque. */
+        default: return 0;
+    }
+
+    u = n->parameters[0];
+    du = derive(u, var);
+    if (!du) return 0;
+
+    if (ARITY(n->type) == 1) {
+        const void *f = n->function;
+        te_expr *inner;
+        /* Constant, as te_compile would have folded it, e.g. fac(5) in a static tree. */
+        if (is_const(du, 0.0)) return du;
+        if (f == te_negate) return d_neg(du);
+        /* Piecewise constant, zero almost everywhere. */
+        if (f == floor || f == ceil) {te_free(du); return d_const(0.0);}
+
+        if (f == sin) inner = d_fun1(cos, d_copy(u));
+        else if (f == cos) inner = d_neg(d_fun1(sin, d_copy(u)));
+        else if (f == tan) inner = d_div(d_const(1.0), d_fun2(pow, d_fun1(cos, d_copy(u)), d_const(2.0)));
+        else if (f == sinh) inner = d_fun1(cosh, d_copy(u));
+        else if (f == cosh) inner = d_fun1(sinh, d_copy(u));
+        else if (f == tanh) inner = d_div(d_const(1.0), d_fun2(pow, d_fun1(cosh, d_copy(u)), d_const(2.0)));
+        else if (f == exp) inner = d_copy(n);
+        else if (f == log) inner = d_div(d_const(1.0), d_copy(u));
+        else if (f == log10) inner = d_div(d_const(1.0), d_mul(d_copy(u), d_const(log(10.0))));
+        else if (f == sqrt) inner = d_div(d_const(0.5), d_copy(n));
+        else if (f == asin || f == acos) {
+            inner = d_div(d_const(f == asin ? 1.0 : -1.0),
+                          d_fun1(sqrt, d_sub(d_const(1.0), d_fun2(pow, d_copy(u), d_const(2.0)))));
+        }
+        else if (f == atan) inner = d_div(d_const(1.0), d_add(d_const(1.0), d_fun2(pow, d_copy(u), d_const(2.0))));
+        else if (f == fabs) inner = d_div(d_copy(u), d_copy(n));
+        else {te_free(du); return 0;}
+        return d_mul(inner, du);
+    }
+
+    v = n->parameters[1];
+    if (n->function == te_comma) {te_free(du); return derive(v, var);}
+    dv = derive(v, var);
+    if (!dv) {te_free(du); return 0;}
+    if (is_const(du, 0.0) && is_const(dv, 0.0)) {te_free(dv); return du;}
+
+    if (n->function == te_add) return d_add(du, dv);
+    if (n->function == te_sub) return d_sub(du, dv);
+    if (n->function == te_mul) return d_add(d_mul(du, d_copy(v)), d_mul(d_copy(u), dv));
+    if (n->function == te_divide) {
+        return d_div(d_sub(d_mul(du, d_copy(v)), d_mul(d_copy(u), dv)),
+                     d_fun2(pow, d_copy(v), d_const(2.0)));
+    }
+    if (n->function == pow) {
+        if (is_const(dv, 0.0)) {
+            /* u^c -> c*u^(c-1)*u' */
+            te_free(dv);
+            return d_mul(d_mul(d_copy(v), d_fun2(pow, d_copy(u), d_sub(d_copy(v), d_const(1.0)))), du);
+        }
+        /* u^v -> u^v*(v'*ln(u) + v*u'/u) */
+        return d_mul(d_copy(n), d_add(d_mul(dv, d_fun1(log, d_copy(u))),
+                                      d_div(d_mul(d_copy(v), du), d_copy(u))));
+    }
+    if (n->function == fmod && is_const(dv, 0.0)) {te_free(dv); return du;}
+    if (n->function == atan2) {
+        /* atan2(u, v) -> (v*u' - u*v')/(u^2 + v^2) */
+        return d_div(d_sub(d_mul(d_copy(v), du), d_mul(d_copy(u), dv)),
+                     d_add(d_fun2(pow, d_copy(u), d_const(2.0)), d_fun2(pow, d_copy(v), d_const(2.0))));
+    }
+    te_free(du);
+    te_free(dv);
+    return 0;
+}
+
+
+te_expr *te_derive(const te_expr *n, const double *var) {
+    te_expr *ret;
+    if (!n) return 0;
+    ret = derive(n, var);
+    if (ret) {
+        optimize(ret);
+        specialize(ret);
+    }
+    return ret;
+}
+
+
+int te_uses(const te_expr *n, const double *var) {
+    int i;
+    if (!n) return 0;
+    if (TYPE_MASK(n->type) == TE_VARIABLE) return n->bound == var;
+    for (i = 0; i < ARITY(n->type); ++i) {
+        if (te_uses(n->parameters[i], var)) return 1;
+    }
+    return 0;
+}
+
+
+/* Complex evaluation. Values are carried as separate real and imaginary */
+/* parts. A function whose arguments are all real and inside its real domain */
+/* is called as is, so real results are exactly those of te_eval. */
+
+typedef struct {double re, im;} te_cplx;
+
+static te_cplx c_make(double re, double im) {
+    te_cplx z;
+    z.re = re;
+    z.im = im;
+    return z;
+}
+
+#ifndef TE_NO_COMPLEX
+static te_cplx c_mul(te_cplx a, te_cplx b) {
+    return c_make(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re);
+}
+
+static te_cplx c_div(te_cplx a, te_cplx b) {
+    /* Smith's method, the squares of b do not overflow */
+    double r, d;
+    if (fabs(b.re) >= fabs(b.im)) {
+        r = b.im / b.re;
+        d = b.re + b.im * r;
+        return c_make((a.re + a.im * r) / d, (a.im - a.re * r) / d);
+    }
+    r = b.re / b.im;
+    d = b.re * r + b.im;
+    return c_make((a.re * r + a.im) / d, (a.im * r - a.re) / d);
+}
+
+static te_cplx c_exp(te_cplx z) {
+    const double m = exp(z.re);
+    return c_make(m * cos(z.im), m * sin(z.im));
+}
+
+static te_cplx c_log(te_cplx z) {
+    return c_make(log(hypot(z.re, z.im)), atan2(z.im, z.re));
+}
+
+static te_cplx c_sqrt(te_cplx z) {
+    double t;
+    if (z.re == 0 && z.im == 0) return z;
+    t = sqrt((fabs(z.re) + hypot(z.re, z.im)) / 2);
+    if (z.re >= 0) return c_make(t, z.im / (2 * t));
+    /* The sign of a zero imaginary part picks the side of the cut, as in C99 csqrt */
+    return c_make(fabs(z.im) / (2 * t), signbit(z.im) ? -t : t);
+}
+
+static te_cplx c_powi(te_cplx a, int k) {
+    unsigned int u = k < 0 ? -k : k;
+    te_cplx ret = c_make(1, 0);
+    while (u) {
+        if (u & 1) ret = c_mul(ret, a);
+        a = c_mul(a, a);
+        u >>= 1;
+    }
+    return k < 0 ? c_div(c_make(1, 0), ret) : ret;
+}
+
+static te_cplx c_pow(te_cplx a, te_cplx b) {
+    if (a.re == 0 && a.im == 0) return c_make(b.re > 0 ? 0 : NAN, 0);
+    return c_exp(c_mul(b, c_log(a)));
+}
+
+static te_cplx c_sin(te_cplx z) {return c_make(sin(z.re) * cosh(z.im), cos(z.re) * sinh(z.im));}
+static te_cplx c_cos(te_cplx z) {return c_make(cos(z.re) * cosh(z.im), -sin(z.re) * sinh(z.im));}
+static te_cplx c_sinh(te_cplx z) {return c_make(sinh(z.re) * cos(z.im), cosh(z.re) * sin(z.im));}
+static te_cplx c_cosh(te_cplx z) {return c_make(cosh(z.re) * cos(z.im), sinh(z.re) * sin(z.im));}
+
+static te_cplx c_asin(te_cplx z) {
+    /* -i*ln(i*z + sqrt(1 - z^2)) */
+    const te_cplx s = c_sqrt(c_make(1 - (z.re * z.re - z.im * z.im), -2 * z.re * z.im));
+    const te_cplx w = c_log(c_make(s.re - z.im, s.im + z.re));
+    return c_make(w.im, -w.re);
+}
+
+static te_cplx c_atan(te_cplx z) {
+    /* i/2*(ln(1 - i*z) - ln(1 + i*z)) */
+    const te_cplx a = c_log(c_make(1 + z.im, -z.re)), b = c_log(c_make(1 - z.im, z.re));
+    return c_make((b.im - a.im) / 2, (a.re - b.re) / 2);
+}
+
+/* n applied to complex arguments. Functions without a complex form give NaN */
+/* for arguments off the real axis. */
+static te_cplx c_apply(const te_expr *n, const double *re, const double *im) {
+    const void *f = n->function;
+    const int arity = ARITY(n->type);
+    te_cplx a, b, r;
+    int i, real = 1;
+    for (i = 0; i < arity; ++i) if (im[i] != 0) real = 0;
+    if (real && in_real_domain(n, re)) return c_make(apply(n, re), 0);
+    if (IS_CLOSURE(n->type) || arity == 0 || arity > 2) return c_make(NAN, NAN);
+    a = c_make(re[0], im[0]);
+    b = arity == 2 ? c_make(re[1], im[1]) : a;
+
+    switch(OPCODE(n->type)) {
+        case TE_OP_ADD: return c_make(a.re + b.re, a.im + b.im);
+        case TE_OP_SUB: return c_make(a.re - b.re, a.im - b.im);
+        case TE_OP_MUL: return c_mul(a, b);
+        case TE_OP_DIV: return c_div(a, b);
+        case TE_OP_NEG: return c_make(-a.re, -a.im);
+        case TE_OP_POW: return c_pow(a, b);
+        case TE_OP_POWI: return c_powi(a, (int)((const te_expr*)n->parameters[1])->value);
+        case TE_OP_SIN: return c_sin(a);
+        case TE_OP_COS: return c_cos(a);
+    }
+    if (f == te_comma) return b;
+    if (f == exp) return c_exp(a);
+    if (f == log) return c_log(a);
+    if (f == log10) {r = c_log(a); return c_make(r.re / log(10.0), r.im / log(10.0));}
+    if (f == sqrt) return c_sqrt(a);
+    if (f == tan) return c_div(c_sin(a), c_cos(a));
+    if (f == sinh) return c_sinh(a);
+    if (f == cosh) return c_cosh(a);
+    if (f == tanh) return c_div(c_sinh(a), c_cosh(a));
+    if (f == asin) return c_asin(a);
+    if (f == acos) {r = c_asin(a); return c_make(3.14159265358979323846 / 2 - r.re, -r.im);}
+    if (f == atan) return c_atan(a);
+    if (f == fabs) return c_make(hypot(a.re, a.im), 0);
+    return c_make(NAN, NAN);
+}
+#else
+/* Without complex forms the arguments are always real */
+static te_cplx c_apply(const te_expr *n, const double *re, const double *im) {
+    (void)im;
+    return c_make(apply(n, re), 0);
+}
+#endif
+
+
+double te_eval_complex(const te_expr *n, double *im) {
+    *im = 0;
+    if (!n) return NAN;
+    /* Leaves and real subtrees stay on the real path */
+    if ((!IS_FUNCTION(n->type) && !IS_CLOSURE(n->type)) || IS_REAL(n->type)) return te_eval(n);
+    {
+        const int arity = ARITY(n->type);
+        double re[arity ? arity : 1], ims[arity ? arity : 1];
+        te_cplx r;
+        int i;
+        for (i = 0; i < arity; ++i) re[i] = te_eval_complex(n->parameters[i], &ims[i]);
+        r = c_apply(n, re, ims);
+        *im = r.im;
+        return r.re;
+    }
+}
+
+
+#ifndef __AVR__
+/* Points per pass of the batch evaluator, the arrays of one node fit in L1 */
+#define TE_BATCH 64
+
+static void batch_real(const te_expr *n, const double *var, const double *xs, double *out, int count) {
+    const int arity = ARITY(n->type);
+    double args[arity ? arity : 1][TE_BATCH];
+    double x[7];
+    int i, k;
+    switch(TYPE_MASK(n->type)) {
+        case TE_CONSTANT: for (i = 0; i < count; ++i) out[i] = n->value; return;
+        case TE_VARIABLE:
+            if (n->bound == var) memcpy(out, xs, count * sizeof(double));
+            else for (i = 0; i < count; ++i) out[i] = *n->bound;
+            return;
+    }
+    for (k = 0; k < arity; ++k) batch_real(n->parameters[k], var, xs, args[k], count);
+    switch(IS_CLOSURE(n->type) ? TE_OP_NONE : OPCODE(n->type)) {
+        case TE_OP_ADD: for (i = 0; i < count; ++i) out[i] = args[0][i] + args[1][i]; return;
+        case TE_OP_SUB: for (i = 0; i < count; ++i) out[i] = args[0][i] - args[1][i]; return;
+        case TE_OP_MUL: for (i = 0; i < count; ++i) out[i] = args[0][i] * args[1][i]; return;
+        case TE_OP_DIV: for (i = 0; i < count; ++i) out[i] = args[0][i] / args[1][i]; return;
+        case TE_OP_NEG: for (i = 0; i < count; ++i) out[i] = -args[0][i]; return;
+    }
+    for (i = 0; i < count; ++i) {
+        for (k = 0; k < arity; ++k) x[k] = args[k][i];
+        out[i] = apply(n, x);
+    }
+}
+
+static void batch_complex(const te_expr *n, const double *var, const double *xs, double *re, double *im, int count) {
+    const int arity = ARITY(n->type);
+    double are[arity ? arity : 1][TE_BATCH], aim[arity ? arity : 1][TE_BATCH];
+    double x[7], y[7];
+    te_cplx r;
+    int i, k;
+    if ((!IS_FUNCTION(n->type) && !IS_CLOSURE(n->type)) || IS_REAL(n->type)) {
+        batch_real(n, var, xs, re, count);
+        memset(im, 0, count * sizeof(double));
+        return;
+    }
+    for (k = 0; k < arity; ++k) batch_complex(n->parameters[k], var, xs, are[k], aim[k], count);
+    switch(IS_CLOSURE(n->type) ? TE_OP_NONE : OPCODE(n->type)) {
+        case TE_OP_ADD:
+            for (i = 0; i < count; ++i) {re[i] = are[0][i] + are[1][i]; im[i] = aim[0][i] + aim[1][i];}
+            return;
+        case TE_OP_SUB:
+            for (i = 0; i < count; ++i) {re[i] = are[0][i] - are[1][i]; im[i] = aim[0][i] - aim[1][i];}
+            return;
+        case TE_OP_NEG:
+            for (i = 0; i < count; ++i) {re[i] = -are[0][i]; im[i] = -aim[0][i];}
+            return;
+        case TE_OP_MUL:
+            for (i = 0; i < count; ++i) {
+                /* Real operands keep an exact zero imaginary part, as in c_apply */
+                const int real = aim[0][i] == 0 && aim[1][i] == 0;
+                re[i] = are[0][i] * are[1][i] - aim[0][i] * aim[1][i];
+                im[i] = real ? 0 : are[0][i] * aim[1][i] + aim[0][i] * are[1][i];
+            }
+            return;
+    }
+    for (i = 0; i < count; ++i) {
+        for (k = 0; k < arity; ++k) {x[k] = are[k][i]; y[k] = aim[k][i];}
+        r = c_apply(n, x, y);
+        re[i] = r.re;
+        im[i] = r.im;
+    }
+}
+
+void te_eval_complex_batch(const te_expr *n, const double *var, const double *xs, double *re, double *im, int count) {
+    int done;
+    for (done = 0; done < count; done += TE_BATCH) {
+        const int c = count - done < TE_BATCH ? count - done : TE_BATCH;
+        if (!n) {
+            int i;
+            for (i = 0; i < c; ++i) re[done + i] = im[done + i] = NAN;
+            continue;
+        }
+        batch_complex(n, var, xs + done, re + done, im + done, c);
+    }
+}
+#endif
+
+
 double te_interp(const char *expression, int *error) {
     te_expr *n = te_compile(expression, 0, 0, error);
     double ret;
@@ -38,7 +38,7 @@ typedef struct te_expr {
 
 
 enum {
-    TE_VARIABLE = 0,
+    TE_VARIABLE = 0, TE_CONSTANT,
 
     TE_FUNCTION0 = 8, TE_FUNCTION1, TE_FUNCTION2, TE_FUNCTION3,
     TE_FUNCTION4, TE_FUNCTION5, TE_FUNCTION6, TE_FUNCTION7,
@@ -46,9 +46,29 @@ enum {
     TE_CLOSURE0 = 16, TE_CLOSURE1, TE_CLOSURE2, TE_CLOSURE3,
     TE_CLOSURE4, TE_CLOSURE5, TE_CLOSURE6, TE_CLOSURE7,
 
-    TE_FLAG_PURE = 32
+    TE_FLAG_PURE = 32,
+    /* Set by te_compile on function nodes whose value is real whenever the */
+    /* variables are, so complex evaluation runs them through te_eval. */
+    TE_FLAG_REAL = 64,
+    /* Set on the root of a tree in static storage, e.g. from TE_STATIC, */
+    /* which te_free leaves alone. */
+    TE_FLAG_STATIC = 128
 };
 
+/* Kernels te_eval runs inline in a switch instead of through the function */
+/* pointer. The operators and the matching builtins get them at compile time, */
+/* a TE_FUNCTION variable can declare one with TE_OPCODE in its type, e.g. */
+/* {"sine", my_sin, TE_FUNCTION1 | TE_FLAG_PURE | TE_OPCODE(TE_OP_SIN)}. */
+enum {
+    TE_OP_NONE = 0,
+    TE_OP_ADD, TE_OP_SUB, TE_OP_MUL, TE_OP_DIV, TE_OP_NEG,
+    TE_OP_POW,
+    TE_OP_POWI,         /* pow with a small integer constant exponent, by multiplication */
+    TE_OP_SIN, TE_OP_COS
+};
+
+#define TE_OPCODE(OP) ((OP) << 8)
+
 typedef struct te_variable {
     const char *name;
     const void *address;
@@ -69,6 +89,67 @@ te_expr *te_compile(const char *expression, const te_variable *variables, int va
 /* Evaluates the expression. */
 double te_eval(const te_expr *n);
 
+#ifndef __AVR__
+/* Per-call values for variables, so threads can share one compiled tree. */
+/* A variable bound to slots[i], i < count, reads values[i] instead; other */
+/* variables are still read through their address. Closures and functions */
+/* that keep state, such as user functions, are not made re-entrant. */
+typedef struct te_frame {
+    const double *slots;
+    const double *values;
+    int count;
+} te_frame;
+
+/* Evaluates the expression with variable values from frame. */
+double te_eval_frame(const te_expr *n, const te_frame *frame);
+#endif
+
+/* Evaluates the expression over the complex numbers, with real variables. */
+/* Returns the real part and stores the imaginary part in *im, e.g. 2i for */
+/* sqrt(-4). Subtrees that stay real for real variables were marked by */
+/* te_compile and go through te_eval, so real results match it exactly. */
+/* Functions without a complex form, such as fac, give NaN off the real axis. */
+/* Built with TE_NO_COMPLEX it gives te_eval's result and *im = 0. */
+double te_eval_complex(const te_expr *n, double *im);
+
+#ifndef __AVR__
+/* Complex evaluation for count values xs of the variable bound at var, */
+/* into separate real and imaginary arrays. The tree is evaluated one node */
+/* at a time over a block of points, so the arithmetic runs as loops over */
+/* arrays. Other variables are read once per block, and functions that */
+/* keep state see the points in a different order than te_eval. */
+void te_eval_complex_batch(const te_expr *n, const double *var, const double *xs,
+                           double *re, double *im, int count);
+#endif
+
+/* Builds the exact derivative of a compiled expression with respect to the */
+/* variable bound at var. Returns NULL when it contains a closure or a */
+/* function without a known derivative, such as fac or ncr. */
+te_expr *te_derive(const te_expr *n, const double *var);
+
+/* Whether the expression reads the variable bound at var. The bodies of */
+/* closures, such as user functions, are not searched. */
+int te_uses(const te_expr *n, const double *var);
+
+/* Looks up names missing from the te_compile variables before the builtins, */
+/* e.g. in an indexed symbol table. Returns NULL for unknown names. The */
+/* result is only read during the call, so it may point to scratch storage. */
+typedef const te_variable *(*te_resolver)(const char *name, int len);
+void te_set_resolver(te_resolver resolver);
+
+/* The builtins and operators without a libm counterpart. Trees built */
+/* outside te_compile point their nodes here so te_eval, te_derive and */
+/* te_eval_complex recognise them. */
+double te_add(double a, double b);
+double te_sub(double a, double b);
+double te_mul(double a, double b);
+double te_divide(double a, double b);
+double te_negate(double a);
+double te_comma(double a, double b);
+double te_fac(double a);
+double te_ncr(double n, double r);
+double te_npr(double n, double r);
+
 /* Prints debugging information on the syntax tree. */
 void te_print(const te_expr *n);
 
@@ -76,6 +157,16 @@ void te_print(const te_expr *n);
 /* This is safe to call on NULL pointers. */
 void te_free(te_expr *n);
 
+/* Bytes te_copy needs for a copy of the expression. */
+int te_size(const te_expr *n);
+
+/* Copies the expression into the size bytes at arena, which must be aligned */
+/* for a te_expr, e.g. to keep it in static storage instead of on the heap. */
+/* The copy is marked TE_FLAG_STATIC so te_free leaves it alone, and its */
+/* closures share their context with the original. Returns NULL when it */
+/* needs more than size bytes. */
+te_expr *te_copy(const te_expr *n, void *arena, int size);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,237 @@
+#include "protocol.h"
+#include <string.h>
+#include "../tinyexpr/tinyexpr.h"
+#include "../calculator/symbols.h"
+
+#ifdef __AVR__
+#include <util/crc16.h>
+#include "usart.h"
+#endif
+
+uint8_t proto_export_flags = 0;
+proto_strip_fn proto_strip_sink = NULL;
+
+enum {
+    PARSE_SOF,
+    PARSE_LEN,
+    PARSE_TYPE,
+    PARSE_PAYLOAD,
+    PARSE_CRC_LO,
+    PARSE_CRC_HI
+};
+
+uint16_t proto_crc_update(uint16_t crc, uint8_t data) {
+#ifdef __AVR__
+    return _crc_xmodem_update(crc, data);
+#else
+    crc ^= (uint16_t) data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+#endif
+}
+
+void proto_parser_reset(ProtoParser * parser) {
+    parser->state = PARSE_SOF;
+    parser->pos = 0;
+    parser->crc = 0xFFFF;
+}
+
+bool proto_feed(ProtoParser * parser, uint8_t data) {
+    switch (parser->state) {
+        case PARSE_SOF:
+            if (data == PROTO_SOF) {
+                proto_parser_reset(parser);
+                parser->state = PARSE_LEN;
+            }
+            break;
+        case PARSE_LEN:
+            if (data > PROTO_MAX_PAYLOAD) {
+                proto_parser_reset(parser);
+                break;
+            }
+            parser->frame.len = data;
+            parser->crc = proto_crc_update(parser->crc, data);
+            parser->state = PARSE_TYPE;
+            break;
+        case PARSE_TYPE:
+            parser->frame.type = data;
+            parser->crc = proto_crc_update(parser->crc, data);
+            parser->state = parser->frame.len ? PARSE_PAYLOAD : PARSE_CRC_LO;
+            break;
+        case PARSE_PAYLOAD:
+            parser->frame.payload[parser->pos++] = data;
+            parser->crc = proto_crc_update(parser->crc, data);
+            if (parser->pos == parser->frame.len) parser->state = PARSE_CRC_LO;
+            break;
+        case PARSE_CRC_LO:
+            if (data != (uint8_t) parser->crc) {
+                proto_parser_reset(parser);
+                break;
+            }
+            parser->state = PARSE_CRC_HI;
+            break;
+        case PARSE_CRC_HI: {
+            bool valid = data == (uint8_t) (parser->crc >> 8);
+            proto_parser_reset(parser);
+            return valid;
+        }
+        default:
+            proto_parser_reset(parser);
+            break;
+    }
+    return false;
+}
+
+static void proto_error(ProtoFrame * response, uint8_t code, uint8_t position) {
+    response->type = PROTO_ERROR;
+    response->len = 2;
+    response->payload[0] = code;
+    response->payload[1] = position;
+}
+
+// Compiles a length delimited expression with x bound to *x.
+// The text is copied so the request payload does not need a terminator.
+static te_expr * proto_compile(const uint8_t * text, uint8_t len, double * x, int * err) {
+    char expression[PROTO_MAX_PAYLOAD + 1];
+    memcpy(expression, text, len);
+    expression[len] = '\0';
+    te_variable vars[] = {{"x", x}};
+    return te_compile(expression, vars, 1, err);
+}
+
+void proto_handle(const ProtoFrame * request, ProtoFrame * response) {
+    double x = 0;
+    int err = 0;
+    te_expr *expr;
+    float result;
+    switch (request->type) {
+        case PROTO_PING:
+            response->type = PROTO_PONG;
+            response->len = 0;
+            break;
+        case PROTO_EVAL: {
+            // Definitions are handled by the symbol table, the rest evaluated
+            char text[PROTO_MAX_PAYLOAD + 1];
+            double value;
+            memcpy(text, request->payload, request->len);
+            text[request->len] = '\0';
+            uint8_t status = sym_define(text, &value, &err);
+            if (status == SYM_NONE) {
+                expr = proto_compile(request->payload, request->len, &x, &err);
+                if (!expr) {
+                    status = SYM_ERR_EXPR;
+                } else {
+                    value = te_eval(expr);
+                    te_free(expr);
+                }
+            }
+            if (status == SYM_ERR_EXPR) {
+                proto_error(response, PROTO_ERR_EXPRESSION, err);
+                break;
+            }
+            if (status == SYM_ERR_FULL) {
+                proto_error(response, PROTO_ERR_STORAGE, 0);
+                break;
+            }
+            result = value;
+            response->type = PROTO_RESULT;
+            response->len = sizeof(float);
+            memcpy(response->payload, &result, sizeof(float));
+            break;
+        }
+        case PROTO_EVAL_VEC: {
+            uint8_t text_len = request->payload[0];
+            if (request->len < 1 || text_len > request->len - 1
+                    || (request->len - 1 - text_len) % sizeof(float)) {
+                proto_error(response, PROTO_ERR_LENGTH, 0);
+                break;
+            }
+            expr = proto_compile(request->payload + 1, text_len, &x, &err);
+            if (!expr) {
+                proto_error(response, PROTO_ERR_EXPRESSION, err);
+                break;
+            }
+            const uint8_t *xs = request->payload + 1 + text_len;
+            uint8_t n = (request->len - 1 - text_len) / sizeof(float);
+            for (uint8_t i = 0; i < n; i++) {
+                float xi;
+                memcpy(&xi, xs + i * sizeof(float), sizeof(float));
+                x = xi;
+                result = te_eval(expr);
+                memcpy(response->payload + i * sizeof(float), &result, sizeof(float));
+            }
+            te_free(expr);
+            response->type = PROTO_RESULT_VEC;
+            response->len = n * sizeof(float);
+            break;
+        }
+        case PROTO_EXPORT:
+            if (request->len != 1) {
+                proto_error(response, PROTO_ERR_LENGTH, 0);
+                break;
+            }
+            proto_export_flags = request->payload[0];
+            response->type = PROTO_ACK;
+            response->len = 1;
+            response->payload[0] = proto_export_flags;
+            break;
+        case PROTO_STRIP: {
+            float window[2];
+            if (!proto_strip_sink) {
+                proto_error(response, PROTO_ERR_TYPE, request->type);
+                break;
+            }
+            if (request->len < sizeof(window) || request->len % sizeof(float)) {
+                proto_error(response, PROTO_ERR_LENGTH, 0);
+                break;
+            }
+            memcpy(window, request->payload, sizeof(window));
+            uint8_t n = (request->len - sizeof(window)) / sizeof(float);
+            for (uint8_t i = 0; i < n; i++) {
+                float value;
+                memcpy(&value, request->payload + sizeof(window) + i * sizeof(float), sizeof(float));
+                proto_strip_sink(window[0], window[1], value);
+            }
+            // Echoes the number of samples charted
+            response->type = PROTO_ACK;
+            response->len = 1;
+            response->payload[0] = n;
+            break;
+        }
+        default:
+            proto_error(response, PROTO_ERR_TYPE, request->type);
+            break;
+    }
+}
+
+void proto_send(const ProtoFrame * frame, proto_tx_fn tx) {
+    uint16_t crc = 0xFFFF;
+    tx(PROTO_SOF);
+    tx(frame->len);
+    crc = proto_crc_update(crc, frame->len);
+    tx(frame->type);
+    crc = proto_crc_update(crc, frame->type);
+    for (uint8_t i = 0; i < frame->len; i++) {
+        tx(frame->payload[i]);
+        crc = proto_crc_update(crc, frame->payload[i]);
+    }
+    tx((uint8_t) crc);
+    tx((uint8_t) (crc >> 8));
+}
+
+#ifdef __AVR__
+static ProtoParser parser = {PARSE_SOF, 0, 0xFFFF};
+static ProtoFrame response;
+
+void proto_poll(void) {
+    uint8_t data;
+    while (rx_buff_pop(&data)) {
+        if (proto_feed(&parser, data)) {
+            proto_handle(&parser.frame, &response);
+            proto_send(&response, USART_Transmit_char);
+        }
+    }
+}
+#endif
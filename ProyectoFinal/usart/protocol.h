@@ -0,0 +1,92 @@
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame layout (all multi-byte fields little endian):
+//   PROTO_SOF | len | type | payload[len] | crc16
+// The CRC is CRC-16/CCITT (poly 0x1021, init 0xFFFF) over len, type and payload.
+#define PROTO_SOF 0xA5
+#define PROTO_MAX_PAYLOAD 64
+#define PROTO_FRAME_OVERHEAD 5
+
+// Request and response types. Responses have the MSB set.
+enum proto_type {
+    PROTO_PING = 0x00,          // Empty payload, answered with PROTO_PONG
+    PROTO_EVAL = 0x01,          // Expression or definition ("a=2", "f(t)=t^2") text, answered with PROTO_RESULT
+    PROTO_EVAL_VEC = 0x02,      // Expression length, text and packed float x values, answered with PROTO_RESULT_VEC
+    PROTO_EXPORT = 0x03,        // Plot export flags (enum proto_export), answered with PROTO_ACK
+    PROTO_STRIP = 0x04,         // ymin, ymax and samples as packed floats, answered with PROTO_ACK
+    PROTO_PONG = 0x80,
+    PROTO_RESULT = 0x81,        // One packed float
+    PROTO_RESULT_VEC = 0x82,    // One packed float per x value
+    PROTO_ACK = 0x83,           // Echoes the accepted setting
+    // Unsolicited plot export stream, see calculator/plot_export.h
+    PROTO_PLOT_BEGIN = 0x90,    // xmin, xmax, ymin, ymax as packed floats
+    PROTO_PLOT_SAMPLES = 0x91,  // Function index, first sample index, packed float (x, y) pairs
+    PROTO_PLOT_ROW = 0x92,      // Screen row, first column, (count, RGB565 color) runs
+    PROTO_PLOT_END = 0x93,      // Empty payload
+    PROTO_ERROR = 0xFF          // Error code and expression error position
+};
+
+// Plot export flags, set remotely with PROTO_EXPORT
+enum proto_export {
+    PROTO_EXPORT_SAMPLES = 0x01,
+    PROTO_EXPORT_ROWS = 0x02
+};
+
+extern uint8_t proto_export_flags;
+
+// Receives the samples of PROTO_STRIP frames one by one with the window they
+// are charted in. Set by the application, the frames are refused while NULL.
+typedef void (*proto_strip_fn)(float ymin, float ymax, float value);
+
+extern proto_strip_fn proto_strip_sink;
+
+enum proto_error {
+    PROTO_ERR_TYPE = 1,
+    PROTO_ERR_LENGTH,
+    PROTO_ERR_EXPRESSION,
+    PROTO_ERR_STORAGE           // Definition does not fit in EEPROM or the symbol table
+};
+
+typedef struct proto_frame {
+    uint8_t len;
+    uint8_t type;
+    uint8_t payload[PROTO_MAX_PAYLOAD];
+} ProtoFrame;
+
+typedef struct proto_parser {
+    uint8_t state;
+    uint8_t pos;
+    uint16_t crc;
+    ProtoFrame frame;
+} ProtoParser;
+
+// Sink for outgoing bytes, USART_Transmit_char on the device, which waits
+// for room in the TX ring buffer instead of overwriting queued bytes
+typedef void (*proto_tx_fn)(uint8_t data);
+
+uint16_t proto_crc_update(uint16_t crc, uint8_t data);
+
+// Reset a parser to wait for the next start of frame.
+void proto_parser_reset(ProtoParser * parser);
+
+// Feeds one received byte. Returns true when parser->frame holds a complete,
+// CRC checked frame. Bytes outside of frames (e.g. debug text) are skipped.
+bool proto_feed(ProtoParser * parser, uint8_t data);
+
+// Evaluates a request frame and fills in the response. Transport independent,
+// shared between the device and the host loopback.
+void proto_handle(const ProtoFrame * request, ProtoFrame * response);
+
+// Serializes and transmits a frame through tx.
+void proto_send(const ProtoFrame * frame, proto_tx_fn tx);
+
+#ifdef __AVR__
+// Drains the USART RX ring buffer and answers every complete request.
+void proto_poll(void);
+#endif
+
+#endif /* PROTOCOL_H_ */
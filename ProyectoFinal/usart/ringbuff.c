@@ -35,6 +35,23 @@ uint8_t ringbuff_push(volatile RingBuffer * buff, uint8_t data) {
 	return 0;
 }
 
+size_t ringbuff_push_bulk(volatile RingBuffer * buff, const uint8_t * data, size_t len) {
+	if (!buff || !data) return 0;
+	size_t n;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		// Unlike ringbuff_push, never overwrite unread data: only fill free slots
+		size_t free_slots = (buff->tail + buff->size - buff->head - 1) % buff->size;
+		n = len < free_slots ? len : free_slots;
+		// Copy up to the end of the storage, then wrap around for the rest
+		size_t first = buff->size - buff->head;
+		if (first > n) first = n;
+		memcpy(buff->buffer + buff->head, data, first);
+		memcpy(buff->buffer, data + first, n - first);
+		buff->head = (buff->head + n) % buff->size;
+	}
+	return n;
+}
+
 uint8_t ringbuff_pop(volatile RingBuffer * buff, uint8_t * data) {
 	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
 		if (buff && data && !ringbuff_empty(*buff)) {
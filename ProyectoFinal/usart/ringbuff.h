@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <util/atomic.h>
 
 typedef struct ring_buffer {
@@ -18,6 +19,8 @@ bool ringbuff_empty(volatile RingBuffer buff);
 bool ringbuff_full(volatile RingBuffer buff);
 uint8_t ringbuff_reset(volatile RingBuffer * buff);
 uint8_t ringbuff_push(volatile RingBuffer * buff, uint8_t data);
+// Pushes up to len bytes in one critical section, returns how many fit
+size_t ringbuff_push_bulk(volatile RingBuffer * buff, const uint8_t * data, size_t len);
 uint8_t ringbuff_pop(volatile RingBuffer * buff, uint8_t * data);
 
 #endif /* _RINGBUFF_H_ */
\ No newline at end of file
@@ -16,8 +16,35 @@ uint8_t init_buffers(uint16_t tx_len, uint16_t rx_len) {
 	return 0;
 }
 
-uint16_t baud2ubbr(uint16_t baudrate) {
-	return F_CPU/16/baudrate-1;
+// Error of the last configured baud rate, in 0.1 % units
+static int16_t baud_error = 0;
+
+uint16_t baud2ubbr(uint32_t baudrate, bool * double_speed) {
+	uint16_t best_ubrr = 0;
+	int32_t best_error = INT32_MAX;
+	*double_speed = false;
+	// Try normal (F_CPU/16) and double speed (F_CPU/8) modes, normal first so
+	// it wins ties: it samples each bit more often and tolerates more noise.
+	for (uint8_t divisor = 16; divisor >= 8; divisor /= 2) {
+		uint32_t clocks = divisor * baudrate;
+		// Round to nearest instead of truncating
+		uint32_t ubrr = (F_CPU + clocks / 2) / clocks;
+		ubrr = ubrr ? ubrr - 1 : 0;
+		if (ubrr > 4095) ubrr = 4095;
+		uint32_t actual = F_CPU / (divisor * (ubrr + 1));
+		int32_t error = ((int32_t) actual - (int32_t) baudrate) * 1000 / (int32_t) baudrate;
+		if (labs(error) < labs(best_error)) {
+			best_error = error;
+			best_ubrr = ubrr;
+			*double_speed = divisor == 8;
+		}
+	}
+	baud_error = best_error;
+	return best_ubrr;
+}
+
+int16_t USART_Baud_Error(void) {
+	return baud_error;
 }
 
 void disable_tx_int(void) {
@@ -32,6 +59,10 @@ void rx_buff_push(uint8_t data) {
 	ringbuff_push(&rx_buff, data);
 }
 
+bool rx_buff_pop(uint8_t * data) {
+	return ringbuff_pop(&rx_buff, data) == 0;
+}
+
 bool tx_buff_pop(uint8_t * data) {
 	if (ringbuff_empty(tx_buff)) {
 		disable_tx_int();
@@ -45,7 +76,13 @@ uint8_t USART_Init(struct USART_configuration config) {
 	// Clear control register C
 	UCSR0C = 0;
 	uint8_t ERR_FLAG = 0;
-	uint16_t ubbr = baud2ubbr(config.baud_rate);
+	bool double_speed;
+	uint16_t ubbr = baud2ubbr(config.baud_rate, &double_speed);
+	if (double_speed) {
+		UCSR0A |= (1 << U2X0);
+	} else {
+		UCSR0A &= ~(1 << U2X0);
+	}
 	// Bitshift MSB to LSB in baudrate and write to HIGH register
 	UBRR0H = (uint8_t) (ubbr >> 8);
 	// Right LSB from baudrate to LOW register
@@ -99,6 +136,8 @@ uint8_t USART_Init(struct USART_configuration config) {
 			ERR_FLAG = 3;
 			break;
 	}
+	// More than 2 % off is outside what the receiver on the other side tolerates
+	if (labs(baud_error) > 20) ERR_FLAG = 4;
 	disable_tx_int();
 	return ERR_FLAG;
 }
@@ -112,7 +151,12 @@ void USART_Transmit_char(uint8_t data) {
 	// whenever UDR0 is free.
 	// This requires you to have some bytes in the buffer that you would like to
 	// send, of course. You have a buffer, don't you?
-	ringbuff_push(&tx_buff, data);
+	// Never overwrite queued bytes: wait for the UDRE interrupt to make room,
+	// unless it cannot run, then the byte is dropped like in USART_Transmit_String
+	while (!ringbuff_push_bulk(&tx_buff, &data, 1)) {
+		enable_tx_int();
+		if (!(SREG & (1 << SREG_I))) return;
+	}
 	enable_tx_int();
 }
 
@@ -120,16 +164,15 @@ void USART_Transmit_char(uint8_t data) {
 
 // Transmits a given string
 void USART_Transmit_String(char* string) {
-	bool first_run = true;
-	while (*string) {
-		ringbuff_push(&tx_buff, *string);
-		if (first_run) {
-			//enable_tx_int();
-			first_run = false;
-		}
-		string++;
+	size_t len = strlen(string);
+	while (len) {
+		size_t n = ringbuff_push_bulk(&tx_buff, (const uint8_t *) string, len);
+		enable_tx_int();
+		string += n;
+		len -= n;
+		// Wait for the UDRE interrupt to make room, unless it cannot run
+		if (len && !(SREG & (1 << SREG_I))) break;
 	}
-	enable_tx_int();
 }
 
 
@@ -145,16 +188,17 @@ char USART_Receive_char(void) {
 
 // Receives a '\n' terminated string and writes it into a supplied buffer.
 // The buffer must be guaranteed to handle at least bufflen bytes.
-// Returns the number of bytes written into the buffer.
+// Returns the number of bytes written into the buffer, excluding the '\0'.
 uint8_t USART_Receive_String(char* buffer, uint8_t bufflen) {
 	uint8_t data = 0;
 	uint8_t ctr = 0;
-	for (int i = 0; i <= bufflen; i++) {
-		if (ringbuff_empty(rx_buff)) return ctr;
-		ringbuff_pop(&rx_buff, &data);
-		buffer[i] = data;
+	if (bufflen == 0) return 0;
+	while (ctr < bufflen - 1) {
+		if (ringbuff_pop(&rx_buff, &data)) break;
+		if (data == '\n') break;
+		buffer[ctr] = data;
 		ctr++;
-		if (data == '\n') disable_tx_int();
 	}
+	buffer[ctr] = '\0';
 	return ctr;
-} 
\ No newline at end of file
+}
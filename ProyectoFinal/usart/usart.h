@@ -15,7 +15,7 @@
 
 struct USART_configuration
 {
-	uint16_t baud_rate;
+	uint32_t baud_rate;
 	uint8_t frame_size;
 	uint8_t parity_bits;
 	uint8_t stop_bits;
@@ -27,21 +27,27 @@ void disable_tx_int(void);
 void enable_tx_int(void);
 
 void rx_buff_push(uint8_t data);
+bool rx_buff_pop(uint8_t * data);
 bool tx_buff_pop(uint8_t * data);
 
 // Initialize TX and RX circular buffers
 uint8_t init_buffers(uint16_t tx_len, uint16_t rx_len);
 
-// Convert baud rate to AVR ubbr
-uint16_t baud2ubbr(uint16_t baudrate);
+// Convert baud rate to the closest AVR ubbr, choosing between normal and
+// double speed (U2X0) mode. At 16 MHz 250k, 500k and 1M baud are exact.
+uint16_t baud2ubbr(uint32_t baudrate, bool * double_speed);
 
-// Call once to initialize USART communication
+// Call once to initialize USART communication.
+// Returns 4 if the closest achievable baud rate is more than 2 % off.
 uint8_t USART_Init(struct USART_configuration config);
 
-// Transmits a single character
+// Error of the configured baud rate in 0.1 % units (e.g. 35 = +3.5 %)
+int16_t USART_Baud_Error(void);
+
+// Transmits a single character. Blocks while the TX ring buffer is full.
 void USART_Transmit_char(uint8_t data );
 
-// Transmits a given string
+// Transmits a given string. Blocks while the TX ring buffer is full.
 void USART_Transmit_String(char* string);
 
 // Receives a single character
@@ -49,7 +55,7 @@ char USART_Receive_char(void);
 
 // Receives a '\n' terminated string and writes it into a supplied buffer.
 // The buffer must be guaranteed to handle at least bufflen bytes.
-// Returns the number of bytes written into the buffer.
+// Returns the number of bytes written into the buffer, excluding the '\0'.
 uint8_t USART_Receive_String(char* buffer, uint8_t bufflen);
 
 
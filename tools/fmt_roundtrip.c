@@ -0,0 +1,73 @@
+/*
+ * Exhaustive host check of the LCD number formatter.
+ * Formats every finite float bit pattern at the given width (default 16),
+ * checks the length and, at widths where no digits get rounded off, that
+ * strtof reads the text back to the same float. Complex results are checked
+ * first: random pairs of tiny and huge parts must fit the width as well.
+ *
+ * Build:
+ *   cc -O2 -o fmt_roundtrip tools/fmt_roundtrip.c ProyectoFinal/fmt/fmt.c
+ * Run:
+ *   ./fmt_roundtrip [width]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "../ProyectoFinal/fmt/fmt.h"
+
+#define COMPLEX_PAIRS 1000000
+
+// A random float of either sign, from subnormal to near the largest
+static double random_part(void) {
+    double value = pow(10, -45 + 84.0 * rand() / RAND_MAX);
+    switch (rand() % 16) {
+        case 0: return 0;
+        case 1: return 1;
+        case 2: return -1;
+    }
+    return rand() & 1 ? -value : value;
+}
+
+// Formats random complex values, returns the number longer than width
+static unsigned long check_complex(uint8_t width) {
+    unsigned long failed = 0;
+    srand(1);
+    for (unsigned long i = 0; i < COMPLEX_PAIRS; i++) {
+        double re = random_part(), im = random_part();
+        char buf[64];
+        uint8_t len = fmt_complex(re, im, buf, width);
+        if ((len > width || strlen(buf) != len) && failed++ < 20) {
+            printf("%.9g %+.9gi -> \"%s\"\n", re, im, buf);
+        }
+    }
+    printf("%d complex checked, %lu failed\n", COMPLEX_PAIRS, failed);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    uint8_t width = argc > 1 ? atoi(argv[1]) : FMT_LCD_WIDTH;
+    unsigned long checked = 0, failed = 0;
+    if (width < FMT_MIN_WIDTH) {
+        fprintf(stderr, "width must be at least %d\n", FMT_MIN_WIDTH);
+        return 2;
+    }
+    // fmt_complex only takes LCD widths and up
+    if (width >= FMT_LCD_WIDTH) failed = check_complex(width);
+    for (uint64_t i = 0; i <= 0xFFFFFFFF; i++) {
+        union {uint32_t u; float f;} bits = {(uint32_t) i};
+        if (!isfinite(bits.f)) continue;
+        char buf[32];
+        uint8_t len = fmt_double(bits.f, buf, width);
+        checked++;
+        bool bad = len > width || strlen(buf) != len;
+        // 9 significant digits always round trip, and the 16 columns have
+        // room for them in every layout
+        if (!bad && width >= FMT_LCD_WIDTH) bad = strtof(buf, NULL) != bits.f;
+        if (bad && failed++ < 20) printf("%08lx %.9g -> \"%s\"\n", (unsigned long) i, bits.f, buf);
+    }
+    printf("%lu checked, %lu failed\n", checked, failed);
+    return failed != 0;
+}
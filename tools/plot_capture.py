@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Capture the calculator's plot export stream and rebuild the plot off-device.
+
+Usage:
+  plot_capture.py --port /dev/ttyACM0 [--rows] [--out plot] [--golden ref.ppm]
+
+Enables plot export, then waits for the next plot drawn on the device.
+Writes <out>.csv with the raw (function, index, x, y) samples and, with
+--rows, <out>.ppm with the screen rebuilt from the RLE RGB565 rows.
+With --golden the rebuilt screen is compared pixel by pixel and the exit
+status is 1 on any mismatch, so it can serve as a regression check.
+"""
+
+import argparse
+import struct
+import sys
+
+from remote_eval import (Link, PROTO_EXPORT_ROWS, PROTO_EXPORT_SAMPLES, open_link,
+                         EXPORT, PLOT_BEGIN, PLOT_SAMPLES, PLOT_ROW, PLOT_END)
+
+WIDTH, HEIGHT = 160, 128
+
+
+def rgb565_to_rgb888(color):
+    return ((color >> 11) & 0x1F) << 3, ((color >> 5) & 0x3F) << 2, (color & 0x1F) << 3
+
+
+def capture(link):
+    window, samples = None, []
+    screen = [[None] * WIDTH for _ in range(HEIGHT)]
+    while True:
+        ftype, payload = link.receive()
+        if ftype == PLOT_BEGIN:
+            window = struct.unpack("<4f", payload)
+            samples = []
+        elif ftype == PLOT_SAMPLES:
+            func, first = payload[0], payload[1]
+            values = struct.unpack("<%df" % ((len(payload) - 2) // 4), payload[2:])
+            for i in range(0, len(values), 2):
+                samples.append((func, first + i // 2, values[i], values[i + 1]))
+        elif ftype == PLOT_ROW:
+            row, col = payload[0], payload[1]
+            for i in range(2, len(payload), 3):
+                count, color = payload[i], payload[i + 1] | payload[i + 2] << 8
+                for _ in range(count):
+                    screen[row][col] = color
+                    col += 1
+        elif ftype == PLOT_END and window is not None:
+            return window, samples, screen
+
+
+def write_ppm(path, screen):
+    with open(path, "wb") as f:
+        f.write(b"P6 %d %d 255\n" % (WIDTH, HEIGHT))
+        for row in screen:
+            for color in row:
+                f.write(bytes(rgb565_to_rgb888(color or 0)))
+
+
+def read_ppm(path):
+    with open(path, "rb") as f:
+        header = f.readline().split()
+        data = f.read()
+    width, height = int(header[1]), int(header[2])
+    return [[tuple(data[(r * width + c) * 3:(r * width + c) * 3 + 3]) for c in range(width)]
+            for r in range(height)]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port", required=True)
+    ap.add_argument("--baud", type=int, default=500000)
+    ap.add_argument("--rows", action="store_true", help="also export rendered screen rows")
+    ap.add_argument("--out", default="plot")
+    ap.add_argument("--golden", help="reference .ppm to compare against")
+    args = ap.parse_args()
+    args.loopback = None
+
+    link = open_link(args)
+    flags = PROTO_EXPORT_SAMPLES | (PROTO_EXPORT_ROWS if args.rows or args.golden else 0)
+    link.request(EXPORT, bytes([flags]))
+    print("waiting for a plot...")
+    window, samples, screen = capture(link)
+    print("window x=[%g, %g] y=[%g, %g], %d samples" % (window + (len(samples),)))
+
+    with open(args.out + ".csv", "w") as f:
+        f.write("func,index,x,y\n")
+        for sample in samples:
+            f.write("%d,%d,%.9g,%.9g\n" % sample)
+
+    if flags & PROTO_EXPORT_ROWS:
+        write_ppm(args.out + ".ppm", screen)
+        if args.golden:
+            golden = read_ppm(args.golden)
+            diff = sum(1 for r in range(HEIGHT) for c in range(WIDTH)
+                       if rgb565_to_rgb888(screen[r][c] or 0) != golden[r][c])
+            print("%d pixels differ from %s" % (diff, args.golden))
+            sys.exit(1 if diff else 0)
+
+
+if __name__ == "__main__":
+    main()
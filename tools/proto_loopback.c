@@ -0,0 +1,40 @@
+/*
+ * Host stand-in for the calculator's remote evaluation protocol.
+ * Runs the same frame parser and handler as the firmware against stdin/stdout,
+ * so remote_eval.py can be exercised without a board. Strip chart samples
+ * are printed to stderr.
+ *
+ * Build:
+ *   cc -O2 -o proto_loopback tools/proto_loopback.c \
+ *      ProyectoFinal/usart/protocol.c ProyectoFinal/calculator/symbols.c \
+ *      ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ */
+
+#include <stdio.h>
+#include "../ProyectoFinal/usart/protocol.h"
+#include "../ProyectoFinal/calculator/symbols.h"
+
+static void tx_stdout(uint8_t data) {
+    putchar(data);
+}
+
+static void strip_print(float ymin, float ymax, float value) {
+    fprintf(stderr, "strip [%g, %g] %g\n", ymin, ymax, value);
+}
+
+int main(void) {
+    ProtoParser parser;
+    ProtoFrame response;
+    int c;
+    proto_parser_reset(&parser);
+    sym_init();
+    proto_strip_sink = strip_print;
+    while ((c = getchar()) != EOF) {
+        if (proto_feed(&parser, (uint8_t) c)) {
+            proto_handle(&parser.frame, &response);
+            proto_send(&response, tx_stdout);
+            fflush(stdout);
+        }
+    }
+    return 0;
+}
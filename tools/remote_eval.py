@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Batch expression evaluation against the calculator over its binary protocol.
+
+Usage:
+  remote_eval.py --port /dev/ttyACM0 --baud 500000 "sin(x)*x" [-n 1000]
+  remote_eval.py --loopback ./proto_loopback "sin(x)*x" [-n 1000]
+  remote_eval.py --port /dev/ttyACM0 -D "a=2" -D "f(t)=t^2+a" "f(x)"
+
+Streams n x values in [-1, 1] through PROTO_EVAL_VEC frames, prints the first
+results and the end-to-end evaluations per second. Definitions given with -D
+are sent first and stay in the calculator's EEPROM. Needs pyserial for --port.
+"""
+
+import argparse
+import struct
+import subprocess
+import sys
+import time
+
+SOF = 0xA5
+MAX_PAYLOAD = 64
+PING, EVAL, EVAL_VEC, EXPORT = 0x00, 0x01, 0x02, 0x03
+PONG, RESULT, RESULT_VEC, ACK, ERROR = 0x80, 0x81, 0x82, 0x83, 0xFF
+PLOT_BEGIN, PLOT_SAMPLES, PLOT_ROW, PLOT_END = 0x90, 0x91, 0x92, 0x93
+PROTO_EXPORT_SAMPLES, PROTO_EXPORT_ROWS = 0x01, 0x02
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(ftype, payload=b""):
+    body = bytes([len(payload), ftype]) + payload
+    return bytes([SOF]) + body + struct.pack("<H", crc16(body))
+
+
+class Link:
+    def __init__(self, write, read):
+        self.write = write
+        self.read = read
+
+    def request(self, ftype, payload=b""):
+        self.write(encode(ftype, payload))
+        return self.receive()
+
+    def receive(self):
+        # Skip debug text until a start of frame shows up
+        while self.read(1)[0] != SOF:
+            pass
+        length, ftype = self.read(2)
+        payload = self.read(length)
+        (crc,) = struct.unpack("<H", self.read(2))
+        if crc != crc16(bytes([length, ftype]) + payload):
+            raise IOError("CRC mismatch")
+        if ftype == ERROR:
+            raise ValueError("device error %d at %d" % (payload[0], payload[1]))
+        return ftype, payload
+
+
+def open_link(args):
+    if args.loopback:
+        proc = subprocess.Popen([args.loopback], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+
+        def write(data):
+            proc.stdin.write(data)
+            proc.stdin.flush()
+
+        def read(n):
+            data = proc.stdout.read(n)
+            if len(data) != n:
+                raise EOFError("loopback closed")
+            return data
+
+        return Link(write, read)
+    import serial
+    port = serial.Serial(args.port, args.baud, timeout=5)
+    return Link(port.write, port.read)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("expression")
+    ap.add_argument("-n", type=int, default=1000, help="number of x samples")
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=500000)
+    ap.add_argument("--loopback", help="path to the proto_loopback binary")
+    ap.add_argument("-D", "--define", action="append", default=[],
+                    help='user variable or function, e.g. "a=2" or "f(t)=t^2"')
+    args = ap.parse_args()
+    if not args.port and not args.loopback:
+        ap.error("either --port or --loopback is required")
+
+    link = open_link(args)
+    link.request(PING)
+    for definition in args.define:
+        _, result = link.request(EVAL, definition.encode())
+        print("%s -> %g" % (definition, struct.unpack("<f", result)[0]))
+    expr = args.expression.encode()
+    per_frame = (MAX_PAYLOAD - 1 - len(expr)) // 4
+    if per_frame < 1:
+        sys.exit("expression too long for a vector frame")
+
+    xs = [-1 + 2 * i / max(args.n - 1, 1) for i in range(args.n)]
+    ys = []
+    start = time.perf_counter()
+    for i in range(0, len(xs), per_frame):
+        chunk = xs[i:i + per_frame]
+        payload = bytes([len(expr)]) + expr + struct.pack("<%df" % len(chunk), *chunk)
+        _, result = link.request(EVAL_VEC, payload)
+        ys.extend(struct.unpack("<%df" % len(chunk), result))
+    elapsed = time.perf_counter() - start
+
+    for x, y in list(zip(xs, ys))[:5]:
+        print("%g -> %g" % (x, y))
+    print("%d evaluations in %.3f s: %.1f eval/s" % (len(ys), elapsed, len(ys) / elapsed))
+
+
+if __name__ == "__main__":
+    main()
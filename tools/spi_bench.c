@@ -0,0 +1,145 @@
+/*
+ * Host benchmark of the TFT transports. The drawing routines run against a
+ * mock transport that records the byte stream, and the time it takes on the
+ * bus is worked out for each backend of SPI/spilib.c from the bytes, the
+ * D/C switches and the cycles each backend spends per byte:
+ *
+ *   spi-wait   the SPI module waiting for its own byte, as before
+ *   spi        the SPI module waiting for the previous byte, wr() streams
+ *   usart      USART0 in Master SPI mode, double buffered
+ *
+ * The cycle counts come from the instructions of each loop at 16 MHz, the
+ * bus runs at 8 MHz (16 cycles per byte). The stream is also recorded once
+ * without the transport's tx_repeat, and must come out the same.
+ *
+ * Build:
+ *   cc -O2 -o spi_bench tools/spi_bench.c ProyectoFinal/SPI/spilib.c \
+ *      ProyectoFinal/display/graphic_shapes.c
+ * Run:
+ *   ./spi_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../ProyectoFinal/SPI/spilib.h"
+#include "../ProyectoFinal/display/graphic_shapes.h"
+
+#define F_CPU 16000000.0
+#define BYTE_CYCLES 16
+
+typedef struct backend {
+    const char *name;
+    double byte;            // Cycles per byte sent with wc/wd
+    double repeat_byte;     // Cycles per byte of a wr() stream
+    double mode_switch;     // Extra cycles when D/C changes
+} Backend;
+
+static const Backend backends[] = {
+    // Call, D/C toggle and caller work all wait for the byte
+    {"spi-wait", BYTE_CYCLES + 16, BYTE_CYCLES + 16, 0},
+    // The call overlaps the byte, the poll loop exit, flag update, toggle
+    // and store do not. A stream only keeps the poll loop exit and store.
+    {"spi", BYTE_CYCLES + 8, BYTE_CYCLES + 3, 0},
+    // The buffer hides up to a byte of overhead, a call takes about 22
+    // cycles. A D/C switch empties the buffer and leaves the toggle and
+    // store as a gap.
+    {"usart", 22, BYTE_CYCLES, 6},
+};
+#define N_BACKENDS (sizeof(backends) / sizeof(backends[0]))
+
+typedef struct recorder {
+    uint32_t bytes, repeat_bytes, switches;
+    uint32_t hash;          // FNV-1a of the stream, D/C included
+    int mode;               // Last D/C, -1 before the first byte
+} Recorder;
+
+static void record(Recorder *rec, uint8_t data, bool commandmode) {
+    if (rec->mode >= 0 && rec->mode != commandmode) rec->switches++;
+    rec->mode = commandmode;
+    rec->hash = (rec->hash ^ data) * 16777619u;
+    rec->hash = (rec->hash ^ commandmode) * 16777619u;
+}
+
+static void mock_tx(void *ctx, uint8_t data, bool commandmode) {
+    Recorder *rec = ctx;
+    rec->bytes++;
+    record(rec, data, commandmode);
+}
+
+static void mock_tx_repeat(void *ctx, uint16_t data, uint16_t count) {
+    Recorder *rec = ctx;
+    rec->repeat_bytes += 2 * (uint32_t) count;
+    while (count--) {
+        record(rec, data >> 8, false);
+        record(rec, data & 0xff, false);
+    }
+}
+
+static void fill(void) {
+    fillScreen(0x2945);
+}
+
+static void stream(void) {
+    // A heatmap: one window, every pixel pushed on its own
+    setAddrWindow(0, 0, TFT_WIDTH - 1, TFT_HEIGHT - 1);
+    for (uint16_t i = 0; i < TFT_WIDTH * TFT_HEIGHT; i++) pushColor(i * 37);
+}
+
+static void lines(void) {
+    srand(1);
+    for (int i = 0; i < 64; i++) {
+        drawLine(rand() % TFT_WIDTH, rand() % TFT_HEIGHT, rand() % TFT_WIDTH, rand() % TFT_HEIGHT, 0x07E0);
+    }
+}
+
+static void rects(void) {
+    setScrollOffset(100);
+    for (int i = 0; i < 32; i++) fillRect(i * 5, i * 4, 40, 20, i * 1000);
+    setScrollOffset(0);
+}
+
+static const struct {
+    const char *name;
+    void (*draw)(void);
+} workloads[] = {
+    {"fillScreen", fill},
+    {"pixel stream", stream},
+    {"64 lines", lines},
+    {"32 rects, scrolled", rects},
+};
+
+static Recorder run(void (*draw)(void), bool with_repeat) {
+    Recorder rec = {0, 0, 0, 2166136261u, -1};
+    SpiTransport mock = {mock_tx, with_repeat ? mock_tx_repeat : NULL, &rec};
+    spi_set_transport(&mock);
+    draw();
+    spi_set_transport(NULL);
+    return rec;
+}
+
+int main(void) {
+    int failed = 0;
+    printf("%-20s %8s %8s %8s", "", "bytes", "stream", "D/C");
+    for (unsigned b = 0; b < N_BACKENDS; b++) printf(" %9s", backends[b].name);
+    printf("   ms\n");
+    for (unsigned w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        Recorder rec = run(workloads[w].draw, true);
+        Recorder plain = run(workloads[w].draw, false);
+        if (plain.hash != rec.hash || plain.bytes != rec.bytes + rec.repeat_bytes) {
+            printf("%s: stream differs without tx_repeat\n", workloads[w].name);
+            failed++;
+        }
+        printf("%-20s %8u %8u %8u", workloads[w].name, rec.bytes + rec.repeat_bytes,
+               rec.repeat_bytes, rec.switches);
+        for (unsigned b = 0; b < N_BACKENDS; b++) {
+            const Backend *be = &backends[b];
+            double cycles = rec.bytes * be->byte + rec.repeat_bytes * be->repeat_byte
+                + rec.switches * be->mode_switch;
+            printf(" %9.2f", cycles / F_CPU * 1e3);
+        }
+        printf("\n");
+    }
+    printf("wire time at 8 MHz is %d cycles per byte\n", BYTE_CYCLES);
+    return failed != 0;
+}
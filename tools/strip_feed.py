@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Feed live values to the calculator's strip chart over its binary protocol.
+
+Usage:
+  some_sensor | strip_feed.py --port /dev/ttyACM0 --ymin 0 --ymax 5
+  strip_feed.py --loopback ./proto_loopback --demo --rate 25
+
+Reads one number per line from stdin, or with --demo generates a sine at
+--rate samples per second, and sends each value as it comes in a PROTO_STRIP
+frame with the window [ymin, ymax]. The device scrolls its chart by a column
+per sample; a new window clears it. Needs pyserial for --port.
+"""
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+from remote_eval import PING, open_link
+
+STRIP = 0x04
+
+
+def values(args):
+    if args.demo:
+        period = 1.0 / args.rate
+        next_time = time.perf_counter()
+        for i in range(args.n):
+            yield math.sin(2 * math.pi * i / 64)
+            next_time += period
+            time.sleep(max(0.0, next_time - time.perf_counter()))
+        return
+    for line in sys.stdin:
+        line = line.strip()
+        if line:
+            yield float(line)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--ymin", type=float, default=-1.2)
+    ap.add_argument("--ymax", type=float, default=1.2)
+    ap.add_argument("--demo", action="store_true", help="send a sine instead of stdin")
+    ap.add_argument("--rate", type=float, default=25, help="demo samples per second")
+    ap.add_argument("-n", type=int, default=640, help="demo samples")
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=500000)
+    ap.add_argument("--loopback", help="path to the proto_loopback binary")
+    args = ap.parse_args()
+    if not args.port and not args.loopback:
+        ap.error("either --port or --loopback is required")
+
+    link = open_link(args)
+    link.request(PING)
+    sent = 0
+    start = time.perf_counter()
+    for value in values(args):
+        link.request(STRIP, struct.pack("<3f", args.ymin, args.ymax, value))
+        sent += 1
+    elapsed = time.perf_counter() - start
+    print("%d samples in %.3f s: %.1f samples/s" % (sent, elapsed, sent / elapsed if elapsed else 0))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,75 @@
+/*
+ * Host microbenchmark of te_eval, in nanoseconds per tree node.
+ * Build it twice to compare the inline kernels with pointer dispatch:
+ *
+ *   cc -O2 -o te_bench tools/te_bench.c ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ *   cc -O2 -DTE_NO_INLINE_KERNELS -o te_bench_ptr tools/te_bench.c \
+ *      ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ *
+ * Run:
+ *   ./te_bench [evaluations per expression]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../ProyectoFinal/tinyexpr/tinyexpr.h"
+
+#define RUNS 5
+
+static const char *const expressions[] = {
+    "x*x+2*x-1",
+    "(x+1)/(x-3)-x/2",
+    "x^3-4*x^2+x",
+    "sin(x)*cos(2*x)",
+    "-x^2/(1+x^4)",
+    "sqrt(abs(x))+ln(x*x+1)",
+};
+
+static int count_nodes(const te_expr *n) {
+    int count = 1;
+    int arity = (n->type & (TE_FUNCTION0 | TE_CLOSURE0)) ? n->type & 7 : 0;
+    for (int i = 0; i < arity; i++) count += count_nodes(n->parameters[i]);
+    return count;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    long evals = argc > 1 ? atol(argv[1]) : 1000000;
+    double x;
+    te_variable vars[] = {{"x", &x}};
+    double total_ns = 0;
+    long total_nodes = 0;
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        int err;
+        te_expr *expr = te_compile(expressions[e], vars, 1, &err);
+        if (!expr) {
+            fprintf(stderr, "%s: error at %d\n", expressions[e], err);
+            return 1;
+        }
+        int nodes = count_nodes(expr);
+        // Best of a few runs, the others lost time to the rest of the system
+        double ns = 0;
+        for (int run = 0; run < RUNS; run++) {
+            volatile double sink = 0;
+            double start = now();
+            for (long i = 0; i < evals; i++) {
+                x = -2 + 4.0 * (i & 1023) / 1024;
+                sink += te_eval(expr);
+            }
+            double elapsed = (now() - start) * 1e9;
+            if (!run || elapsed < ns) ns = elapsed;
+        }
+        printf("%-24s %3d nodes %7.2f ns/node\n", expressions[e], nodes, ns / evals / nodes);
+        total_ns += ns;
+        total_nodes += (long) nodes * evals;
+        te_free(expr);
+    }
+    printf("%-24s           %7.2f ns/node\n", "overall", total_ns / total_nodes);
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Host check of complex evaluation. Known values are compared with their
+ * closed forms, and for a set of functions of x every point must give
+ *   - the te_eval result, with a zero imaginary part, wherever that is real,
+ *   - the same bits from te_eval_complex_batch as from te_eval_complex.
+ * The time per point of both forms is printed.
+ *
+ * Build:
+ *   cc -O2 -o te_complex_check tools/te_complex_check.c \
+ *      ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ * Run:
+ *   ./te_complex_check
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "../ProyectoFinal/tinyexpr/tinyexpr.h"
+
+#define POINTS 20000
+#define RUNS 20
+
+static const struct {
+    const char *text;
+    double re, im;
+} known[] = {
+    {"sqrt(-1)", 0, 1},
+    {"sqrt(-4)+1", 1, 2},
+    {"ln(-2)", 0.69314718055994531, 3.14159265358979324},
+    {"(-8)^(1/3)", 1, 1.73205080756887729},
+    {"sqrt(-1)^2", -1, 0},
+    {"sqrt(-1)^-2", -1, 0},
+    {"exp(sqrt(-1)*pi)", -1, 1.2246467991473532e-16},
+    {"asin(2)", 1.57079632679489662, 1.31695789692481671},
+    {"acos(2)", 0, -1.31695789692481671},
+    {"atan(2*sqrt(-1))", 1.57079632679489662, 0.54930614433405485},
+    {"log10(-100)", 2, 1.36437635384184134},
+    {"1/(1+sqrt(-1))", 0.5, -0.5},
+    {"(1+sqrt(-1))^3", -2, 2},
+    {"sin(sqrt(-1))", 0, 1.17520119364380146},
+    {"cos(sqrt(-1))", 1.54308063481524378, 0},
+    {"tan(sqrt(-1))", 0, 0.76159415595576489},
+    {"cosh(sqrt(-1))", 0.54030230586813972, 0},
+    {"abs(3+sqrt(-16))", 5, 0},
+    {"fac(sqrt(-1))", NAN, NAN},
+    {"2^3+sqrt(9)", 11, 0},
+};
+
+static const char *functions[] = {
+    "x^2+3*x-1",
+    "sin(x)*exp(-x/3)",
+    "sqrt(x)+ln(x)",
+    "x^0.5*cos(x)",
+    "asin(x/10)+acos(x/20)",
+    "1/(x-1)+sqrt(x*x-4)",
+    "(x+sqrt(-1))*(x-sqrt(-1))",
+    "1/(1+sqrt(-1)*x)",
+    "sqrt(x)^3-x^(1/3)",
+    "atan2(x,2)+floor(x)",
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int same(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static int close_to(double got, double want) {
+    return isnan(want) ? isnan(got) : fabs(got - want) <= 1e-12 * (1 + fabs(want));
+}
+
+int main(void) {
+    static double xs[POINTS], re[POINTS], im[POINTS];
+    double x;
+    te_variable vars[] = {{"x", &x, TE_VARIABLE, 0}};
+    int failed = 0;
+
+    for (unsigned k = 0; k < sizeof(known) / sizeof(known[0]); k++) {
+        te_expr *expr = te_compile(known[k].text, vars, 1, 0);
+        double i, r = te_eval_complex(expr, &i);
+        if (!expr || !close_to(r, known[k].re) || !close_to(i, known[k].im)) {
+            printf("%s = %.17g%+.17gi, expected %.17g%+.17gi\n",
+                   known[k].text, r, i, known[k].re, known[k].im);
+            failed++;
+        }
+        te_free(expr);
+    }
+
+    for (int p = 0; p < POINTS; p++) xs[p] = -10 + 20.0 * p / POINTS + 1e-3;
+    printf("%-28s %10s %10s\n", "", "ns/point", "batch");
+    for (unsigned k = 0; k < sizeof(functions) / sizeof(functions[0]); k++) {
+        te_expr *expr = te_compile(functions[k], vars, 1, 0);
+        if (!expr) {
+            printf("%s: te_compile error\n", functions[k]);
+            failed++;
+            continue;
+        }
+        te_eval_complex_batch(expr, &x, xs, re, im, POINTS);
+        for (int p = 0; p < POINTS; p++) {
+            double i, r;
+            x = xs[p];
+            r = te_eval_complex(expr, &i);
+            if (!same(r, re[p]) || !same(i, im[p])) {
+                printf("%s: x=%g batch %.17g%+.17gi, scalar %.17g%+.17gi\n",
+                       functions[k], x, re[p], im[p], r, i);
+                failed++;
+                break;
+            }
+            double real = te_eval(expr);
+            if (!isnan(real) && (real != r || i != 0)) {
+                printf("%s: x=%g te_eval %.17g, complex %.17g%+.17gi\n", functions[k], x, real, r, i);
+                failed++;
+                break;
+            }
+        }
+
+        double start = now();
+        for (int run = 0; run < RUNS; run++) {
+            for (int p = 0; p < POINTS; p++) {
+                x = xs[p];
+                re[p] = te_eval_complex(expr, &im[p]);
+            }
+        }
+        double scalar = (now() - start) / RUNS / POINTS;
+        start = now();
+        for (int run = 0; run < RUNS; run++) te_eval_complex_batch(expr, &x, xs, re, im, POINTS);
+        double batch = (now() - start) / RUNS / POINTS;
+        printf("%-28s %10.1f %10.1f\n", functions[k], scalar * 1e9, batch * 1e9);
+        te_free(expr);
+    }
+
+    printf("%d failures\n", failed);
+    return failed != 0;
+}
@@ -0,0 +1,280 @@
+#include "te_jit.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__) || defined(__unix__))
+#define TE_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Node layout as in tinyexpr.c
+#define JIT_CONSTANT 1
+#define JIT_TYPE(TYPE) ((TYPE) & 0x1F)
+#define JIT_OPCODE(TYPE) (((TYPE) >> 8) & 0x7F)
+#define JIT_IS_CLOSURE(TYPE) (((TYPE) & TE_CLOSURE0) != 0)
+#define JIT_ARITY(TYPE) (((TYPE) & (TE_FUNCTION0 | TE_CLOSURE0)) ? ((TYPE) & 7) : 0)
+
+typedef double (*jit_fn)(void);
+
+struct te_jit {
+    const te_expr *expr;
+    jit_fn code;            // NULL when falling back to te_eval
+    size_t size;
+};
+
+#ifdef TE_JIT_X86_64
+
+// Code is emitted into a buffer sized from the node count and the frame
+// slots are allocated at compile time, so the generated code never pushes.
+// Every node leaves its value in xmm0. Intermediate values live in 8-byte
+// slots below rbp, which survive the calls to functions.
+#define JIT_BYTES_PER_NODE 96
+#define JIT_PROLOGUE_BYTES 16
+
+typedef struct jit_buf {
+    uint8_t *code;
+    size_t len;
+    int depth;              // Slots in use
+    int max_depth;
+} JitBuf;
+
+static void emit(JitBuf *b, const void *bytes, size_t n) {
+    memcpy(b->code + b->len, bytes, n);
+    b->len += n;
+}
+
+static void emit1(JitBuf *b, uint8_t byte) {
+    b->code[b->len++] = byte;
+}
+
+static void emit32(JitBuf *b, uint32_t v) {
+    emit(b, &v, 4);
+}
+
+static void emit64(JitBuf *b, uint64_t v) {
+    emit(b, &v, 8);
+}
+
+// mov rax, imm64
+static void mov_rax(JitBuf *b, uint64_t v) {
+    emit1(b, 0x48);
+    emit1(b, 0xB8);
+    emit64(b, v);
+}
+
+// xmm<reg> = bits, through rax
+static void load_double(JitBuf *b, int reg, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, 8);
+    mov_rax(b, bits);
+    const uint8_t movq[] = {0x66, 0x48, 0x0F, 0x6E, (uint8_t) (0xC0 | reg << 3)};
+    emit(b, movq, sizeof(movq));
+}
+
+static int32_t slot_offset(int slot) {
+    return -8 * (slot + 1);
+}
+
+// movsd [rbp + slot], xmm<reg>
+static void store_slot(JitBuf *b, int slot, int reg) {
+    const uint8_t op[] = {0xF2, 0x0F, 0x11, (uint8_t) (0x85 | reg << 3)};
+    emit(b, op, sizeof(op));
+    emit32(b, slot_offset(slot));
+}
+
+// movsd xmm<reg>, [rbp + slot]
+static void load_slot(JitBuf *b, int reg, int slot) {
+    const uint8_t op[] = {0xF2, 0x0F, 0x10, (uint8_t) (0x85 | reg << 3)};
+    emit(b, op, sizeof(op));
+    emit32(b, slot_offset(slot));
+}
+
+// Scalar double op xmm<dst>, xmm<src>: 0x58 add, 0x59 mul, 0x5C sub, 0x5E div
+static void sse_op(JitBuf *b, uint8_t op, int dst, int src) {
+    const uint8_t code[] = {0xF2, 0x0F, op, (uint8_t) (0xC0 | dst << 3 | src)};
+    emit(b, code, sizeof(code));
+}
+
+// movapd xmm<dst>, xmm<src>
+static void move_reg(JitBuf *b, int dst, int src) {
+    const uint8_t code[] = {0x66, 0x0F, 0x28, (uint8_t) (0xC0 | dst << 3 | src)};
+    emit(b, code, sizeof(code));
+}
+
+static int push_slot(JitBuf *b) {
+    int slot = b->depth++;
+    if (b->depth > b->max_depth) b->max_depth = b->depth;
+    return slot;
+}
+
+static void gen(JitBuf *b, const te_expr *n);
+
+// Arguments are evaluated into slots, then loaded into xmm0..xmm6 for the
+// call. Closures get their context in rdi.
+static void gen_call(JitBuf *b, const te_expr *n) {
+    int arity = JIT_ARITY(n->type);
+    int first = b->depth;
+    for (int i = 0; i < arity; i++) {
+        gen(b, n->parameters[i]);
+        store_slot(b, push_slot(b), 0);
+    }
+    for (int i = 0; i < arity; i++) load_slot(b, i, first + i);
+    b->depth = first;
+    if (JIT_IS_CLOSURE(n->type)) {
+        // mov rdi, imm64
+        emit1(b, 0x48);
+        emit1(b, 0xBF);
+        emit64(b, (uint64_t) (uintptr_t) n->parameters[arity]);
+    }
+    mov_rax(b, (uint64_t) (uintptr_t) n->function);
+    // call rax
+    emit1(b, 0xFF);
+    emit1(b, 0xD0);
+}
+
+static void gen_binary(JitBuf *b, const te_expr *n, uint8_t op) {
+    gen(b, n->parameters[0]);
+    int slot = push_slot(b);
+    store_slot(b, slot, 0);
+    gen(b, n->parameters[1]);
+    b->depth--;
+    move_reg(b, 1, 0);
+    load_slot(b, 0, slot);
+    sse_op(b, op, 0, 1);
+}
+
+// Integer power by repeated squaring, unrolled for the constant exponent
+static void gen_powi(JitBuf *b, const te_expr *n) {
+    int k = (int) ((const te_expr *) n->parameters[1])->value;
+    unsigned int u = k < 0 ? -k : k;
+    gen(b, n->parameters[0]);
+    load_double(b, 2, 1.0);
+    while (u) {
+        if (u & 1) sse_op(b, 0x59, 2, 0);
+        u >>= 1;
+        if (u) sse_op(b, 0x59, 0, 0);
+    }
+    if (k < 0) {
+        load_double(b, 0, 1.0);
+        sse_op(b, 0x5E, 0, 2);
+    } else {
+        move_reg(b, 0, 2);
+    }
+}
+
+static void gen(JitBuf *b, const te_expr *n) {
+    switch (JIT_TYPE(n->type)) {
+        case JIT_CONSTANT:
+            load_double(b, 0, n->value);
+            return;
+        case TE_VARIABLE: {
+            mov_rax(b, (uint64_t) (uintptr_t) n->bound);
+            // movsd xmm0, [rax]
+            const uint8_t op[] = {0xF2, 0x0F, 0x10, 0x00};
+            emit(b, op, sizeof(op));
+            return;
+        }
+    }
+    if (!JIT_IS_CLOSURE(n->type)) {
+        switch (JIT_OPCODE(n->type)) {
+            case TE_OP_ADD: gen_binary(b, n, 0x58); return;
+            case TE_OP_SUB: gen_binary(b, n, 0x5C); return;
+            case TE_OP_MUL: gen_binary(b, n, 0x59); return;
+            case TE_OP_DIV: gen_binary(b, n, 0x5E); return;
+            case TE_OP_POWI: gen_powi(b, n); return;
+            case TE_OP_NEG: {
+                gen(b, n->parameters[0]);
+                load_double(b, 1, -0.0);
+                // xorpd xmm0, xmm1
+                const uint8_t op[] = {0x66, 0x0F, 0x57, 0xC1};
+                emit(b, op, sizeof(op));
+                return;
+            }
+        }
+    }
+    // pow, sin, cos and everything else go to the function itself
+    gen_call(b, n);
+}
+
+static size_t count_nodes(const te_expr *n) {
+    size_t count = 1;
+    for (int i = 0; i < JIT_ARITY(n->type); i++) count += count_nodes(n->parameters[i]);
+    return count;
+}
+
+static int jit_lower(te_jit *jit) {
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = JIT_PROLOGUE_BYTES * 2 + count_nodes(jit->expr) * JIT_BYTES_PER_NODE;
+    size = (size + page - 1) / page * page;
+    uint8_t *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return 0;
+
+    JitBuf b = {mem, 0, 0, 0};
+    // push rbp; mov rbp, rsp; sub rsp, frame (patched below)
+    const uint8_t prologue[] = {0x55, 0x48, 0x89, 0xE5, 0x48, 0x81, 0xEC};
+    emit(&b, prologue, sizeof(prologue));
+    size_t frame_at = b.len;
+    emit32(&b, 0);
+    gen(&b, jit->expr);
+    // leave; ret
+    emit1(&b, 0xC9);
+    emit1(&b, 0xC3);
+    // Keep rsp 16-byte aligned at the calls
+    uint32_t frame = (b.max_depth * 8 + 15) & ~15u;
+    memcpy(mem + frame_at, &frame, 4);
+
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC)) {
+        munmap(mem, size);
+        return 0;
+    }
+    jit->code = (jit_fn) (void *) mem;
+    jit->size = size;
+    return 1;
+}
+
+#endif
+
+te_jit *te_jit_compile(const te_expr *expr) {
+    te_jit *jit = malloc(sizeof(te_jit));
+    if (!jit) return NULL;
+    jit->expr = expr;
+    jit->code = NULL;
+    jit->size = 0;
+#ifdef TE_JIT_X86_64
+    if (expr && !getenv("TE_JIT_DISABLE")) jit_lower(jit);
+#endif
+    return jit;
+}
+
+double te_jit_eval(const te_jit *jit) {
+    return jit->code ? jit->code() : te_eval(jit->expr);
+}
+
+void te_jit_eval_batch(const te_jit *jit, double *var, const double *xs, double *ys, int n) {
+    if (jit->code) {
+        jit_fn code = jit->code;
+        for (int i = 0; i < n; i++) {
+            *var = xs[i];
+            ys[i] = code();
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            *var = xs[i];
+            ys[i] = te_eval(jit->expr);
+        }
+    }
+}
+
+int te_jit_native(const te_jit *jit) {
+    return jit->code != NULL;
+}
+
+void te_jit_free(te_jit *jit) {
+    if (!jit) return;
+#ifdef TE_JIT_X86_64
+    if (jit->code) munmap((void *) jit->code, jit->size);
+#endif
+    free(jit);
+}
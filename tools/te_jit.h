@@ -0,0 +1,32 @@
+/*
+ * Native code for compiled tinyexpr trees on x86-64 hosts.
+ * The tree is lowered to scalar SSE2 code in an executable buffer, with
+ * transcendentals and other functions called through their pointers. On
+ * other hosts, or when no executable memory is available, the same calls
+ * fall back to te_eval.
+ */
+
+#ifndef TE_JIT_H_
+#define TE_JIT_H_
+
+#include "../ProyectoFinal/tinyexpr/tinyexpr.h"
+
+typedef struct te_jit te_jit;
+
+// Lowers expr, which must outlive the result. Bound variables are read
+// through their addresses at every evaluation, like te_eval does. Returns
+// NULL only when out of memory.
+te_jit *te_jit_compile(const te_expr *expr);
+
+// Same result as te_eval on the tree.
+double te_jit_eval(const te_jit *jit);
+
+// Evaluates ys[i] with *var = xs[i], var being the variable the tree is bound to.
+void te_jit_eval_batch(const te_jit *jit, double *var, const double *xs, double *ys, int n);
+
+// 1 when jit runs native code, 0 when it falls back to te_eval.
+int te_jit_native(const te_jit *jit);
+
+void te_jit_free(te_jit *jit);
+
+#endif /* TE_JIT_H_ */
@@ -0,0 +1,118 @@
+/*
+ * Host benchmark of the tinyexpr JIT against the tree walker and against
+ * parsing the expression for every sample, in nanoseconds per sample. It also
+ * checks that the JIT gives the same results as te_eval.
+ *
+ * Build:
+ *   cc -O2 -o te_jit_bench tools/te_jit_bench.c tools/te_jit.c \
+ *      ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ *
+ * Run:
+ *   ./te_jit_bench [samples per expression]
+ * Set TE_JIT_DISABLE=1 to time the fallback path.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "te_jit.h"
+
+#define RUNS 5
+// Parsing is far slower, time it over fewer samples
+#define PARSE_DIVISOR 50
+
+static const char *const expressions[] = {
+    "x*x+2*x-1",
+    "(x+1)/(x-3)-x/2",
+    "x^3-4*x^2+x",
+    "sin(x)*cos(2*x)",
+    "-x^2/(1+x^4)",
+    "sqrt(abs(x))+ln(x*x+1)",
+    "x^-3+x^0.5",
+    "atan2(x,1+x*x)*exp(-x)",
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int same(double a, double b) {
+    if (isnan(a) || isnan(b)) return isnan(a) && isnan(b);
+    return a == b || fabs(a - b) <= 1e-12 * fabs(b);
+}
+
+int main(int argc, char **argv) {
+    long samples = argc > 1 ? atol(argv[1]) : 1000000;
+    double x;
+    te_variable vars[] = {{"x", &x}};
+    double *xs = malloc(samples * sizeof(double));
+    double *ys = malloc(samples * sizeof(double));
+    if (!xs || !ys) return 1;
+    for (long i = 0; i < samples; i++) xs[i] = -2 + 4.0 * (i & 1023) / 1024;
+    long parse_samples = samples / PARSE_DIVISOR ? samples / PARSE_DIVISOR : 1;
+    int failed = 0;
+    int native = 1;
+
+    printf("%-24s %9s %9s %9s\n", "ns/sample", "parse", "te_eval", "jit");
+    for (size_t e = 0; e < sizeof(expressions) / sizeof(expressions[0]); e++) {
+        int err;
+        te_expr *expr = te_compile(expressions[e], vars, 1, &err);
+        te_jit *jit = expr ? te_jit_compile(expr) : NULL;
+        if (!jit) {
+            fprintf(stderr, "%s: error at %d\n", expressions[e], err);
+            return 1;
+        }
+
+        double best[3] = {0, 0, 0};
+        for (int run = 0; run < RUNS; run++) {
+            volatile double sink = 0;
+            double start = now();
+            for (long i = 0; i < parse_samples; i++) {
+                x = xs[i];
+                te_expr *parsed = te_compile(expressions[e], vars, 1, &err);
+                sink += te_eval(parsed);
+                te_free(parsed);
+            }
+            double t0 = (now() - start) / parse_samples;
+
+            start = now();
+            for (long i = 0; i < samples; i++) {
+                x = xs[i];
+                sink += te_eval(expr);
+            }
+            double t1 = (now() - start) / samples;
+
+            start = now();
+            te_jit_eval_batch(jit, &x, xs, ys, samples);
+            double t2 = (now() - start) / samples;
+
+            if (!run || t0 < best[0]) best[0] = t0;
+            if (!run || t1 < best[1]) best[1] = t1;
+            if (!run || t2 < best[2]) best[2] = t2;
+        }
+
+        for (long i = 0; i < samples && i < 1024; i++) {
+            x = xs[i];
+            double want = te_eval(expr);
+            if (!same(ys[i], want) || !same(te_jit_eval(jit), want)) {
+                fprintf(stderr, "%s: x=%.17g jit %.17g te_eval %.17g\n",
+                        expressions[e], xs[i], ys[i], want);
+                failed = 1;
+                break;
+            }
+        }
+        printf("%-24s %9.2f %9.2f %9.2f\n", expressions[e],
+               best[0] * 1e9, best[1] * 1e9, best[2] * 1e9);
+        native &= te_jit_native(jit);
+        te_jit_free(jit);
+        te_free(expr);
+    }
+    printf("%s code, results %s\n", native ? "native" : "fallback", failed ? "differ" : "match");
+    free(xs);
+    free(ys);
+    return failed;
+}
@@ -0,0 +1,119 @@
+/*
+ * Host check of the compile-time front end against te_compile and te_eval.
+ * Every expression is built both ways and sampled over a range of x; the
+ * results must be identical. The bound static tree must also match the
+ * compiled one under te_eval and te_eval_complex, and its te_derive result
+ * to rounding.
+ *
+ * Build:
+ *   cc -O2 -c -o tinyexpr.o ProyectoFinal/tinyexpr/tinyexpr.c
+ *   c++ -std=c++14 -O2 -o te_static_check tools/te_static_check.cpp tinyexpr.o -lm
+ * Run:
+ *   ./te_static_check
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "../ProyectoFinal/tinyexpr/te_static.hpp"
+
+#define CASE(TEXT) {TEXT, [](double x) { return TE_STATIC(TEXT)(x); }, \
+                         [](const double *x) { return TE_STATIC(TEXT).bind(x); }}
+
+struct Case {
+    const char *text;
+    double (*eval)(double);
+    te_expr *(*bind)(const double *x);
+};
+
+static bool same(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static bool close(double a, double b) {
+    return same(a, b) || fabs(a - b) <= 1e-12 * fmax(fabs(a), fabs(b));
+}
+
+static const Case cases[] = {
+    CASE("x*x+2*x-1"),
+    CASE("(x+1)/(x-3)-x/2"),
+    CASE("x^3-4*x^2+x"),
+    CASE("sin(x)*cos(2*x)"),
+    CASE("-x^2/(1+x^4)"),
+    CASE("sqrt(x*x)+ln(x*x+1)"),
+    CASE("x^-3+x^0.5"),
+    CASE("atan2(x,1+x*x)*exp(-x)"),
+    CASE("2^3^2+x"),
+    CASE("-2^2*x"),
+    CASE("sin x^2"),
+    CASE("pi*e+pi()*x"),
+    CASE("1e3*x + .5e-2 - 3.25E+1"),
+    CASE("fac(5)+ncr(6,2)+npr(5,2)+x"),
+    CASE("x%3"),
+    CASE("(1,2,x)"),
+    CASE("  x  *  - - -x"),
+    CASE("1/0+x"),
+    CASE("log(x)+log10(x)"),
+    CASE("floor(x)+ceil(x)+tanh(x)+sinh(x)+cosh(x)+tan(x)"),
+    CASE("asin(x/9)+acos(x/9)+atan(x)"),
+    CASE("pow(x,2)+x^16+x^-16+x^17"),
+    CASE("0.1+0.2+x"),
+    CASE("abs(x-1)*abs(x)"),
+};
+
+int main(void) {
+    double x;
+    te_variable vars[] = {{"x", &x, TE_VARIABLE, 0}};
+    int failed = 0;
+    for (const Case &c : cases) {
+        int err;
+        te_expr *expr = te_compile(c.text, vars, 1, &err);
+        if (!expr) {
+            printf("%s: te_compile error at %d\n", c.text, err);
+            failed++;
+            continue;
+        }
+        te_expr *bound = c.bind(&x);
+        te_expr *d_expr = te_derive(expr, &x), *d_bound = te_derive(bound, &x);
+        if (!d_expr != !d_bound) {
+            printf("%s: te_derive %s only for the bound tree\n", c.text, d_bound ? "succeeds" : "fails");
+            failed++;
+        }
+        for (int i = -40; i <= 40; i++) {
+            x = i / 7.0 + 0.01;
+            double want = te_eval(expr), got = c.eval(x);
+            if (!same(want, got)) {
+                printf("%s: x=%g te_eval %.17g static %.17g\n", c.text, x, want, got);
+                failed++;
+                break;
+            }
+            got = te_eval(bound);
+            if (!same(want, got)) {
+                printf("%s: x=%g te_eval %.17g bound %.17g\n", c.text, x, want, got);
+                failed++;
+                break;
+            }
+            double want_im, got_im;
+            want = te_eval_complex(expr, &want_im);
+            got = te_eval_complex(bound, &got_im);
+            if (!same(want, got) || !same(want_im, got_im)) {
+                printf("%s: x=%g te_eval_complex %.17g%+.17gi bound %.17g%+.17gi\n",
+                       c.text, x, want, want_im, got, got_im);
+                failed++;
+                break;
+            }
+            if (d_expr && d_bound && !close(want = te_eval(d_expr), got = te_eval(d_bound))) {
+                printf("%s: x=%g te_derive %.17g bound %.17g\n", c.text, x, want, got);
+                failed++;
+                break;
+            }
+        }
+        te_free(d_expr);
+        te_free(d_bound);
+        // A no-op on the static tree
+        te_free(bound);
+        te_free(expr);
+    }
+
+    printf("%d of %d expressions differ\n", failed, (int) (sizeof(cases) / sizeof(cases[0])));
+    return failed != 0;
+}
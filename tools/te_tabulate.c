@@ -0,0 +1,118 @@
+#include "te_tabulate.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Each worker owns a range of samples. It takes chunks from the front, and
+// when it runs dry it moves the back half of another worker's range into its
+// own. The ranges are locked for the few instructions it takes to split
+// them, which is noise next to a chunk of evaluations.
+typedef struct tab_worker {
+    pthread_mutex_t lock;
+    long begin;
+    long end;
+    int id;
+    struct tab_job *job;
+    pthread_t thread;
+    char pad[64];           // Keep the locks of neighbours off one cache line
+} TabWorker;
+
+typedef struct tab_job {
+    const te_expr *expr;
+    const double *var;
+    double xmin;
+    double step;
+    double *ys;
+    int count;
+    TabWorker *workers;
+} TabJob;
+
+static int take_chunk(TabWorker *w, long *begin, long *end) {
+    pthread_mutex_lock(&w->lock);
+    *begin = w->begin;
+    *end = w->begin + TAB_CHUNK < w->end ? w->begin + TAB_CHUNK : w->end;
+    w->begin = *end;
+    pthread_mutex_unlock(&w->lock);
+    return *begin < *end;
+}
+
+// Moves the back half of the first victim with more than a chunk left
+static int steal(TabWorker *w) {
+    TabJob *job = w->job;
+    for (int i = 1; i < job->count; i++) {
+        TabWorker *victim = &job->workers[(w->id + i) % job->count];
+        long begin = 0, end = 0;
+        pthread_mutex_lock(&victim->lock);
+        long left = victim->end - victim->begin;
+        if (left > TAB_CHUNK) {
+            begin = victim->end - left / 2;
+            end = victim->end;
+            victim->end = begin;
+        }
+        pthread_mutex_unlock(&victim->lock);
+        if (begin < end) {
+            pthread_mutex_lock(&w->lock);
+            w->begin = begin;
+            w->end = end;
+            pthread_mutex_unlock(&w->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void *tab_run(void *arg) {
+    TabWorker *w = arg;
+    TabJob *job = w->job;
+    double x;
+    te_frame frame = {job->var, &x, 1};
+    long begin, end;
+    do {
+        while (take_chunk(w, &begin, &end)) {
+            for (long i = begin; i < end; i++) {
+                x = job->xmin + job->step * i;
+                job->ys[i] = te_eval_frame(job->expr, &frame);
+            }
+        }
+    } while (steal(w));
+    return NULL;
+}
+
+int te_tabulate(const te_expr *expr, const double *var, double xmin, double xmax,
+                double *ys, long n, int threads) {
+    if (n <= 0) return 0;
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? cpus : 1;
+    }
+    if (threads > n / TAB_CHUNK + 1) threads = n / TAB_CHUNK + 1;
+    TabWorker *workers = calloc(threads, sizeof(TabWorker));
+    if (!workers) threads = 1;
+
+    TabWorker single;
+    TabJob job = {expr, var, xmin, n > 1 ? (xmax - xmin) / (n - 1) : 0, ys, threads,
+                  workers ? workers : &single};
+    for (int i = 0; i < threads; i++) {
+        TabWorker *w = &job.workers[i];
+        pthread_mutex_init(&w->lock, NULL);
+        w->begin = n * i / threads;
+        w->end = n * (i + 1) / threads;
+        w->id = i;
+        w->job = &job;
+    }
+    // The calling thread is worker 0, the rest steal whatever failed to start
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&job.workers[i].thread, NULL, tab_run, &job.workers[i])) break;
+        started++;
+    }
+    tab_run(&job.workers[0]);
+    for (int i = 1; i < started; i++) pthread_join(job.workers[i].thread, NULL);
+    // Ranges of workers that never started are still in place
+    for (int i = started; i < threads; i++) {
+        if (job.workers[i].begin < job.workers[i].end) tab_run(&job.workers[i]);
+    }
+    for (int i = 0; i < threads; i++) pthread_mutex_destroy(&job.workers[i].lock);
+    free(workers);
+    return started;
+}
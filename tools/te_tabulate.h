@@ -0,0 +1,22 @@
+/*
+ * Parallel tabulation of a compiled tinyexpr tree on the host.
+ * Every thread evaluates the shared tree with te_eval_frame and its own x, so
+ * the tree and the bound variable are never written.
+ */
+
+#ifndef TE_TABULATE_H_
+#define TE_TABULATE_H_
+
+#include "../ProyectoFinal/tinyexpr/tinyexpr.h"
+
+// Samples handed out at a time. Thieves take half of what a thread has left.
+#define TAB_CHUNK 4096
+
+// Fills ys[i] with expr at x = xmin + (xmax - xmin) * i / (n - 1), x being
+// the variable bound at var. threads <= 0 uses one per online CPU. Returns
+// the number of threads that ran, falling back to the calling thread alone
+// when none can be started.
+int te_tabulate(const te_expr *expr, const double *var, double xmin, double xmax,
+                double *ys, long n, int threads);
+
+#endif /* TE_TABULATE_H_ */
@@ -0,0 +1,85 @@
+/*
+ * Host benchmark of te_tabulate from 1 to N threads, with speedup over one
+ * thread. Every run is checked against te_eval on the bound variable.
+ *
+ * Build:
+ *   cc -O2 -pthread -o te_tabulate_bench tools/te_tabulate_bench.c \
+ *      tools/te_tabulate.c ProyectoFinal/tinyexpr/tinyexpr.c -lm
+ *
+ * Run:
+ *   ./te_tabulate_bench [max threads] [samples] [expression]
+ * The defaults are one thread per online CPU, 10M samples and a mix of
+ * arithmetic and libm calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "te_tabulate.h"
+
+#define RUNS 3
+#define XMIN -10.0
+#define XMAX 10.0
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 1 ? atoi(argv[1]) : (cpus > 0 ? cpus : 1);
+    long samples = argc > 2 ? atol(argv[2]) : 10000000;
+    const char *text = argc > 3 ? argv[3] : "sin(x)*exp(-x^2/8)+x^3/(1+x^2)";
+    double x;
+    te_variable vars[] = {{"x", &x}};
+    int err;
+    te_expr *expr = te_compile(text, vars, 1, &err);
+    if (!expr) {
+        fprintf(stderr, "%s: error at %d\n", text, err);
+        return 1;
+    }
+    double *ys = malloc(samples * sizeof(double));
+    double *want = malloc(samples * sizeof(double));
+    if (!ys || !want) return 1;
+    double step = samples > 1 ? (XMAX - XMIN) / (samples - 1) : 0;
+    for (long i = 0; i < samples; i++) {
+        x = XMIN + step * i;
+        want[i] = te_eval(expr);
+    }
+
+    printf("%s, %ld samples, %ld CPUs\n", text, samples, cpus);
+    printf("%8s %10s %10s %8s\n", "threads", "ms", "ns/sample", "speedup");
+    double base = 0;
+    int failed = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        double best = 0;
+        int ran = 0;
+        for (int run = 0; run < RUNS; run++) {
+            double start = now();
+            ran = te_tabulate(expr, &x, XMIN, XMAX, ys, samples, threads);
+            double elapsed = now() - start;
+            if (!run || elapsed < best) best = elapsed;
+        }
+        for (long i = 0; i < samples; i++) {
+            // Same operations in the same order, so the results are identical
+            if (ys[i] != want[i] && !(ys[i] != ys[i] && want[i] != want[i])) {
+                fprintf(stderr, "%d threads: sample %ld is %.17g, expected %.17g\n",
+                        threads, i, ys[i], want[i]);
+                failed = 1;
+                break;
+            }
+        }
+        if (threads == 1) base = best;
+        printf("%8d %10.1f %10.2f %7.2fx", threads, best * 1e3, best * 1e9 / samples, base / best);
+        // Fewer run when there are not enough chunks or threads fail to start
+        if (ran < threads) printf(" (%d ran)", ran);
+        printf("\n");
+    }
+    te_free(expr);
+    free(ys);
+    free(want);
+    return failed;
+}